@@ -0,0 +1,192 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2025 Benny Meisels <benny.meisels@gmail.com>
+#                    Rani Hod <rani.hod@gmail.com>
+#
+# SPDX-License-Identifier: Apache-2.0
+
+"""Build the EEPROM font pack image; see src/fontpack.h for the format.
+
+Glyphs are given like the built-in font in screen.c: 8x8 bitmaps, top row
+in the most significant byte, leftmost column in the most significant bit.
+"""
+
+import struct
+import sys
+import zlib
+
+FONTPACK_MAGIC = 0x544E4648  # 'HFNT'
+FONTPACK_VERSION = 2
+FONTPACK_COMBINING = 0x80
+FONTPACK_ALIGN_START = 0x40  # combining mark sits on the glyph's left edge
+FONTPACK_ALIGN_END = 0x20    # ... or on its right edge
+
+# lowercase bases for accented letters (x-height, top two rows free)
+BASE = {
+    'a': 0x0000780C7CCC7600,
+    'c': 0x00003C6660663C00,
+    'e': 0x00003C667E603C00,
+    'i': 0x0000381818183C00,  # dotless
+    'n': 0x0000DC6666666600,
+    'o': 0x00003C6666663C00,
+    'u': 0x0000CCCCCCCC7600,
+    'y': 0x00006666663E067C,
+}
+
+# accents for the two top rows
+GRAVE = 0x3018 << 48
+ACUTE = 0x0C18 << 48
+CIRC = 0x1866 << 48
+DIAER = 0x0066 << 48
+TILDE = 0x76DC << 48
+
+LATIN1 = {
+    0xA0: 0,                    # no-break space
+    0xA1: 0x00180018183C3C18,   # ¡
+    0xA2: 0x18187EC0C07E1818,   # ¢
+    0xA3: 0x386C64F060E6FC00,   # £
+    0xA5: 0x66663C7E187E1800,   # ¥
+    0xA7: 0x3E613C66663C867C,   # §
+    0xA9: 0x7E81BDA1A1BD817E,   # ©
+    0xAB: 0x003366CC66330000,   # «
+    0xB0: 0x386C6C3800000000,   # °
+    0xB1: 0x18187E1818007E00,   # ±
+    0xB2: 0x7018306078000000,   # ²
+    0xB3: 0x7818301878000000,   # ³
+    0xB5: 0x00006666667C60C0,   # µ
+    0xB7: 0x0000001818000000,   # ·
+    0xB9: 0x3070303078000000,   # ¹
+    0xBB: 0x00CC663366CC0000,   # »
+    0xBF: 0x001800183060663C,   # ¿
+    0xD7: 0x0000663C183C6600,   # ×
+    0xE0: BASE['a'] | GRAVE,    # à
+    0xE1: BASE['a'] | ACUTE,    # á
+    0xE2: BASE['a'] | CIRC,     # â
+    0xE4: BASE['a'] | DIAER,    # ä
+    0xE7: BASE['c'] | 0x18,     # ç
+    0xE8: BASE['e'] | GRAVE,    # è
+    0xE9: BASE['e'] | ACUTE,    # é
+    0xEA: BASE['e'] | CIRC,     # ê
+    0xEB: BASE['e'] | DIAER,    # ë
+    0xEC: BASE['i'] | GRAVE,    # ì
+    0xED: BASE['i'] | ACUTE,    # í
+    0xEE: BASE['i'] | CIRC,     # î
+    0xEF: BASE['i'] | DIAER,    # ï
+    0xF1: BASE['n'] | TILDE,    # ñ
+    0xF2: BASE['o'] | GRAVE,    # ò
+    0xF3: BASE['o'] | ACUTE,    # ó
+    0xF4: BASE['o'] | CIRC,     # ô
+    0xF6: BASE['o'] | DIAER,    # ö
+    0xF7: 0x0018007E00180000,   # ÷
+    0xF9: BASE['u'] | GRAVE,    # ù
+    0xFA: BASE['u'] | ACUTE,    # ú
+    0xFB: BASE['u'] | CIRC,     # û
+    0xFC: BASE['u'] | DIAER,    # ü
+    0xFD: BASE['y'] | ACUTE,    # ý
+    0xFF: BASE['y'] | DIAER,    # ÿ
+}
+
+# Hebrew letters leave the top and bottom rows free, so niqqud are
+# combining marks drawn there and OR-ed onto the preceding letter
+HEBREW = {
+    0x5B0: (0x0000000000000024, 0),                     # sheva
+    0x5B4: (0x0000000000000010, 0),                     # hiriq
+    0x5B5: (0x0000000000000028, 0),                     # tsere
+    0x5B6: (0x0000000000000054, 0),                     # segol
+    0x5B7: (0x0000000000000038, 0),                     # patah
+    0x5B8: (0x000000000000007C, 0),                     # qamats
+    0x5B9: (0x8000000000000000, FONTPACK_ALIGN_START),  # holam
+    0x5BB: (0x0000000000000054, 0),                     # qubuts
+    0x5BC: (0x0000000010000000, 0),                     # dagesh
+    0x5BE: (0x00007E0000000000, None),                  # maqaf
+    0x5C1: (0x0100000000000000, FONTPACK_ALIGN_END),    # shin dot
+    0x5C2: (0x8000000000000000, FONTPACK_ALIGN_START),  # sin dot
+    0x5C3: (0x0000181800181800, None),                  # sof pasuq
+    0x5F3: (0x0C18300000000000, None),                  # geresh
+    0x5F4: (0x36366C0000000000, None),                  # gershayim
+}
+
+SHEKEL = {
+    0x20AA: 0x00F2DAD2D2D6F600,  # ₪
+}
+
+ICONS = {
+    0xE000: 0x00367F7F3E1C0800,  # heart
+    0xE001: 0x3C42A581A599423C,  # smiley
+    0xE002: 0x3C42A58199A5423C,  # frown
+    0xE003: 0x0F0909090B7B7830,  # note
+    0xE004: 0x1818FF7E3C3C6642,  # star
+    0xE005: 0x0001030706CC7830,  # check
+    0xE006: 0xC3663C18183C66C3,  # cross
+    0xE007: 0x3C7EDBFF7E3C2424,  # skull
+}
+
+
+def columns(bitmap):
+    """Trimmed columns, left to right; bit r is row r (bit 0 = bottom)."""
+    cols = []
+    for x in range(8):
+        col = 0
+        for r in range(8):
+            if (bitmap >> (8 * r + 7 - x)) & 1:
+                col |= 1 << r
+        cols.append(col)
+    used = [x for x, col in enumerate(cols) if col]
+    if not used:
+        return [0, 0]  # blank glyphs are 2 columns, like space
+    return cols[used[0]:used[-1] + 1]
+
+
+def record(bitmap, flags=0):
+    cols = columns(bitmap)
+    return bytes([len(cols) | flags] + cols + [0] * (8 - len(cols)))
+
+
+def build():
+    ranges = []
+    for glyphs in (LATIN1, HEBREW, SHEKEL, ICONS):
+        # split each table into runs of consecutive code points
+        points = sorted(glyphs)
+        first = prev = points[0]
+        for cp in points[1:] + [None]:
+            if cp is not None and cp - prev <= 4:  # fill small holes
+                prev = cp
+                continue
+            recs = b''
+            for c in range(first, prev + 1):
+                g = glyphs.get(c)
+                if g is None:
+                    recs += bytes(9)  # width 0: not present
+                elif isinstance(g, tuple):
+                    bitmap, align = g
+                    flags = 0 if align is None else FONTPACK_COMBINING | align
+                    recs += record(bitmap, flags)
+                else:
+                    recs += record(g)
+            ranges.append((first, prev + 1 - first, recs))
+            if cp is not None:
+                first = prev = cp
+
+    header_size = 12 + 6 * len(ranges)
+    offset = header_size
+    table = b''
+    data = b''
+    for first, count, recs in ranges:
+        table += struct.pack('<HHH', first, count, offset)
+        offset += len(recs)
+        data += recs
+    # the CRC in the header lets the firmware tell a rebuilt pack from the
+    # installed one by reading the header only
+    body = table + data
+    header = struct.pack('<IBBHI', FONTPACK_MAGIC, FONTPACK_VERSION,
+                         len(ranges), header_size + len(data), zlib.crc32(body))
+    return header + body
+
+
+if __name__ == '__main__':
+    if len(sys.argv) != 2:
+        sys.exit(f'usage: {sys.argv[0]} fontpack.bin')
+    image = build()
+    with open(sys.argv[1], 'wb') as f:
+        f.write(image)
+    print(f'font pack: {len(image)} bytes')
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2025 Benny Meisels <benny.meisels@gmail.com>
+ *                    Rani Hod <rani.hod@gmail.com>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Writes the font pack to the EEPROM, unless the same pack (by header,
+// which carries its CRC) is already there, and reads it back to check.
+
+#include <zephyr/device.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/drivers/eeprom.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/printk.h>
+
+#include "fontpack.h"
+#include "persist.h"
+
+#if DT_HAS_COMPAT_STATUS_OKAY(atmel_at24)
+#define EEP_NODE DT_COMPAT_GET_ANY_STATUS_OKAY(atmel_at24)
+#else
+#define EEP_NODE DT_COMPAT_GET_ANY_STATUS_OKAY(zephyr_sim_eeprom) // native_sim
+#endif
+
+static const uint8_t fontpack_image[] = {
+#include "fontpack.inc"
+};
+
+BUILD_ASSERT(sizeof(fontpack_image) <= EEPROM_FONT_SIZE);
+
+static int fontpack_verify(const struct device *eeprom)
+{
+	uint8_t buf[EEPROM_PAGE_SIZE];
+	for (size_t pos = 0; pos < sizeof(fontpack_image); pos += sizeof(buf)) {
+		size_t len = MIN(sizeof(buf), sizeof(fontpack_image) - pos);
+		int rc = eeprom_read(eeprom, EEPROM_FONT_OFFSET + pos, buf, len);
+		if (rc < 0)
+			return rc;
+		if (memcmp(buf, fontpack_image + pos, len)) {
+			printk("[%s] mismatch at byte %zu.\n", __func__, pos);
+			return -EIO;
+		}
+	}
+	return 0;
+}
+
+int main(void)
+{
+	const struct device *const eeprom = DEVICE_DT_GET(EEP_NODE);
+	if ( ! device_is_ready(eeprom)) {
+		printk("[%s] EEPROM device not ready\n", __func__);
+		return 0;
+	}
+
+	uint8_t hdr[FONTPACK_HEADER_SIZE];
+	int rc = eeprom_read(eeprom, EEPROM_FONT_OFFSET, hdr, sizeof(hdr));
+	if (rc == 0 && ! memcmp(hdr, fontpack_image, sizeof(hdr))) {
+		printk("Font pack already installed; flash the game firmware.\n");
+		return 0;
+	}
+
+	printk("Writing the font pack, %zu bytes.\n", sizeof(fontpack_image));
+	rc = eeprom_write(eeprom, EEPROM_FONT_OFFSET, fontpack_image,
+		sizeof(fontpack_image));
+	if (rc == 0)
+		rc = fontpack_verify(eeprom);
+	if (rc < 0) {
+		printk("[%s] install failed; code=%d.\n", __func__, rc);
+		return 0;
+	}
+	printk("Font pack installed; flash the game firmware.\n");
+	return 0;
+}
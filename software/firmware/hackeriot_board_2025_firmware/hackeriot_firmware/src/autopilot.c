@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2025 Benny Meisels <benny.meisels@gmail.com>
+ *                    Rani Hod <rani.hod@gmail.com>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "autopilot.h"
+#include "bitboard.h"
+
+// free cells a shortcut must leave ahead of the tail, beyond the growth
+// due: a shortcut strands the cells it skips until the tail passes them,
+// and targets landing just ahead meanwhile eat into the rest
+#define AUTOPILOT_MARGIN	24
+
+// index of a cell along the cycle: even rows go left, odd rows go right
+static unsigned cycle_index(unsigned pos)
+{
+	unsigned row = pos / 8, col = pos % 8;
+	return row * 8 + ((row & 1) ? 7 - col : col);
+}
+
+// cells from a forward to b along the cycle, 1 to 64
+static unsigned cycle_dist(unsigned a, unsigned b)
+{
+	unsigned d = (cycle_index(b) - cycle_index(a)) & 63;
+	return d ? d : 64;
+}
+
+static uint64_t wrap_neighbors(uint64_t x)
+{
+	return bb_wrap_up(x) | bb_wrap_left(x) | bb_wrap_down(x) | bb_wrap_right(x);
+}
+
+// cells reachable from seed through free
+static unsigned flood_area(uint64_t seed, uint64_t free)
+{
+	uint64_t reach = seed, frontier = seed;
+	while (frontier) {
+		frontier = wrap_neighbors(frontier) & free & ~reach;
+		reach |= frontier;
+	}
+	return bb_count(reach);
+}
+
+unsigned autopilot_snake(const struct snake_data_t *sd)
+{
+	unsigned head = SNAKE_POS(sd, 0);
+	unsigned tail = SNAKE_POS(sd, sd->len - 1);
+
+	// the next tick drops the tail unless the snake grows
+	bool tail_moves = ! sd->grow;
+	uint64_t blocked = sd->occupied & ~(tail_moves ? BB_BIT(tail) : 0);
+	unsigned growth = sd->grow ? sd->grow - 1 : 0;	// due after this tick
+
+	uint64_t next[4] = {
+		bb_wrap_up(BB_BIT(head)),
+		bb_wrap_left(BB_BIT(head)),
+		bb_wrap_down(BB_BIT(head)),
+		bb_wrap_right(BB_BIT(head)),
+	};
+
+	// BFS distance from the target to each free neighbor of the head
+	unsigned dist[4] = { 64, 64, 64, 64 };
+	uint64_t wanted = (next[0] | next[1] | next[2] | next[3]) & ~blocked;
+	uint64_t reach = BB_BIT(sd->target_pos), frontier = reach;
+	for (unsigned d = 0; frontier && wanted; d++) {
+		for (unsigned i = 0; i < 4; i++)
+			if (frontier & wanted & next[i])
+				dist[i] = d;
+		wanted &= ~frontier;
+		frontier = wrap_neighbors(frontier) & ~blocked & ~reach;
+		reach |= frontier;
+	}
+
+	// the closest safe move; the cycle successor is one while the
+	// invariant holds, so best is only -1 on a lost board
+	int best = -1;
+	unsigned best_key = UINT32_MAX;
+	for (unsigned i = 0; i < 4; i++) {
+		if (next[i] & blocked)
+			continue;
+		unsigned n = bb_first(next[i]);
+
+		// stay between the head and the tail along the cycle, and do not
+		// jump past the target, so every move gets closer to it
+		unsigned step = cycle_dist(head, n);
+		if (step > cycle_dist(head, tail) || step > cycle_dist(head, sd->target_pos))
+			continue;
+		// and leave a free cell ahead of the tail per segment still to grow
+		unsigned new_tail = tail_moves ? (sd->len > 1 ? SNAKE_POS(sd, sd->len - 2) : n) : tail;
+		unsigned room = cycle_dist(n, new_tail) - 1;
+		unsigned need = growth + (n == sd->target_pos);
+		if (step > 1)
+			need += AUTOPILOT_MARGIN;
+		if (room < need)
+			continue;
+
+		unsigned key = dist[i] * 64 + cycle_dist(n, sd->target_pos) % 64;
+		if (key < best_key) {
+			best_key = key;
+			best = i;
+		}
+	}
+	if (best >= 0)
+		return best;
+
+	// Hamiltonian fallback: the cycle successor if free; else, off the
+	// cycle, the free neighbor with the largest flood-filled area
+	int fallback = -1;
+	unsigned fallback_area = 0;
+	for (unsigned i = 0; i < 4; i++) {
+		if (next[i] & blocked)
+			continue;
+		if (cycle_dist(head, bb_first(next[i])) == 1)
+			return i;
+		unsigned area = flood_area(next[i], ~blocked);
+		if (area > fallback_area) {
+			fallback_area = area;
+			fallback = i;
+		}
+	}
+	return (fallback >= 0) ? fallback : sd->direction; // or crash
+}
@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) 2025 Benny Meisels <benny.meisels@gmail.com>
+ *                    Rani Hod <rani.hod@gmail.com>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef __BITBOARD_H__
+#define __BITBOARD_H__
+
+#include <zephyr/kernel.h>
+
+// Bitboards: a whole 8x8 frame in one uint64_t, the same layout as
+// screen_set(). Pixel pos = row * 8 + col is bit pos; row 0 is the bottom
+// row, col 0 the rightmost column. So "up" and "left" are towards higher
+// bits, and moving a pixel by (rows, cols) adds 8 * rows + cols to pos.
+// All operations are word operations without data-dependent branches.
+
+#define BB_COLUMN_0		0x0101010101010101ULL	// rightmost column
+#define BB_COLUMN_7		0x8080808080808080ULL	// leftmost column
+#define BB_ROW_0		0x00000000000000FFULL	// bottom row
+#define BB_ROW_7		0xFF00000000000000ULL	// top row
+
+#define BB_POS(row, col)	((row) * 8 + (col))
+#define BB_BIT(pos)			(1ULL << (pos))
+#define BB_COLUMN(col)		(BB_COLUMN_0 << (col))
+#define BB_ROW(row)			(BB_ROW_0 << (8 * (row)))
+
+// a bitboard from 8 row bytes, top row first, e.g. 0b01100110
+#define BB_ROWS(r7, r6, r5, r4, r3, r2, r1, r0) ( \
+	((uint64_t)(r7) << 56) | ((uint64_t)(r6) << 48) | \
+	((uint64_t)(r5) << 40) | ((uint64_t)(r4) << 32) | \
+	((uint64_t)(r3) << 24) | ((uint64_t)(r2) << 16) | \
+	((uint64_t)(r1) <<  8) |  (uint64_t)(r0))
+
+// shift by one pixel; pixels pushed off the edge are lost
+static inline uint64_t bb_up(uint64_t x)	{ return x << 8; }
+static inline uint64_t bb_down(uint64_t x)	{ return x >> 8; }
+static inline uint64_t bb_left(uint64_t x)	{ return (x & ~BB_COLUMN_7) << 1; }
+static inline uint64_t bb_right(uint64_t x)	{ return (x & ~BB_COLUMN_0) >> 1; }
+
+// shift by one pixel on a torus; pixels pushed off the edge come back on
+// the other side
+static inline uint64_t bb_wrap_up(uint64_t x)	{ return (x << 8) | (x >> 56); }
+static inline uint64_t bb_wrap_down(uint64_t x)	{ return (x >> 8) | (x << 56); }
+static inline uint64_t bb_wrap_left(uint64_t x)
+{
+	return ((x & ~BB_COLUMN_7) << 1) | ((x & BB_COLUMN_7) >> 7);
+}
+static inline uint64_t bb_wrap_right(uint64_t x)
+{
+	return ((x & ~BB_COLUMN_0) >> 1) | ((x & BB_COLUMN_0) << 7);
+}
+
+// shift up by rows and left by cols, both in -7..7 (negative is down or
+// right); pixels pushed off the edge are lost
+static inline uint64_t bb_shift(uint64_t x, int rows, int cols)
+{
+	unsigned l = MAX(cols, 0), r = MAX(-cols, 0);
+	unsigned u = MAX(rows, 0), d = MAX(-rows, 0);
+	x = (x & (BB_COLUMN_0 * (0xFFU >> l))) << l;
+	x = (x & (BB_COLUMN_0 * ((0xFFU << r) & 0xFFU))) >> r;
+	return (x << (8 * u)) >> (8 * d);
+}
+
+// mirror top-bottom
+static inline uint64_t bb_flip_vertical(uint64_t x)
+{
+	return __builtin_bswap64(x);
+}
+
+// mirror left-right, i.e. reverse the bits of each byte (Cortex-M0+ has
+// no RBIT)
+static inline uint64_t bb_flip_horizontal(uint64_t x)
+{
+	x = ((x >> 1) & 0x5555555555555555ULL) | ((x & 0x5555555555555555ULL) << 1);
+	x = ((x >> 2) & 0x3333333333333333ULL) | ((x & 0x3333333333333333ULL) << 2);
+	x = ((x >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((x & 0x0F0F0F0F0F0F0F0FULL) << 4);
+	return x;
+}
+
+// swap (row, col) with (col, row), mirroring along the bottom-right to
+// top-left diagonal; three delta swaps
+static inline uint64_t bb_transpose(uint64_t x)
+{
+	uint64_t t;
+	t = 0x0F0F0F0F00000000ULL & (x ^ (x << 28));
+	x ^= t ^ (t >> 28);
+	t = 0x3333000033330000ULL & (x ^ (x << 14));
+	x ^= t ^ (t >> 14);
+	t = 0x5500550055005500ULL & (x ^ (x << 7));
+	x ^= t ^ (t >> 7);
+	return x;
+}
+
+static inline uint64_t bb_rotate_cw(uint64_t x)
+{
+	return bb_flip_horizontal(bb_transpose(x));
+}
+
+static inline uint64_t bb_rotate_ccw(uint64_t x)
+{
+	return bb_flip_vertical(bb_transpose(x));
+}
+
+static inline uint64_t bb_rotate_180(uint64_t x)
+{
+	return bb_flip_horizontal(bb_flip_vertical(x));
+}
+
+// filled rectangle with its bottom-right pixel at (row, col), rows and
+// cols in 1..8; clipped at the top and left edges
+static inline uint64_t bb_rect(unsigned row, unsigned col,
+	unsigned rows, unsigned cols)
+{
+	uint64_t line = ((0xFFU >> (8 - cols)) << col) & 0xFFU;
+	return ((BB_COLUMN_0 * line) & (~0ULL >> (64 - 8 * rows))) << (8 * row);
+}
+
+// straight line from (row0, col0) to (row1, col1), both ends included;
+// a DDA in 8.8 fixed point with a fixed 8 steps
+static inline uint64_t bb_line(unsigned row0, unsigned col0,
+	unsigned row1, unsigned col1)
+{
+	int dr = (int)row1 - (int)row0, dc = (int)col1 - (int)col0;
+	int n = MAX(MAX(dr, -dr), MAX(dc, -dc));
+	int d = n + (n == 0);
+	int sr = dr * 256 / d, sc = dc * 256 / d;
+	int r = row0 * 256 + 128, c = col0 * 256 + 128;
+	uint64_t x = 0;
+	for (int i = 0; i < 8; i++) {
+		uint64_t on = (uint64_t)(i <= n);
+		x |= on << BB_POS((r >> 8) & 7, (c >> 8) & 7);
+		r += sr;
+		c += sc;
+	}
+	return x;
+}
+
+// draw sprite moved by (rows, cols) as in bb_shift(), where its mask
+// is set and clip allows
+static inline uint64_t bb_blit(uint64_t dst, uint64_t sprite, uint64_t mask,
+	int rows, int cols, uint64_t clip)
+{
+	uint64_t m = bb_shift(mask, rows, cols) & clip;
+	return (dst & ~m) | (bb_shift(sprite, rows, cols) & m);
+}
+
+static inline unsigned bb_count(uint64_t x)
+{
+	return __builtin_popcountll(x);
+}
+
+static inline unsigned bb_count_row(uint64_t x, unsigned row)
+{
+	return bb_count(x & BB_ROW(row));
+}
+
+static inline unsigned bb_count_column(uint64_t x, unsigned col)
+{
+	return bb_count(x & BB_COLUMN(col));
+}
+
+// pos of the lowest set bit; x must not be 0
+static inline unsigned bb_first(uint64_t x)
+{
+	return __builtin_ctzll(x);
+}
+
+// pos of the k-th (from 0) set bit, by halving with popcounts;
+// k must be below bb_count(x)
+static inline unsigned bb_select(uint64_t x, unsigned k)
+{
+	unsigned pos = 0;
+	for (unsigned w = 32; w; w >>= 1) {
+		unsigned c = bb_count((x >> pos) & ((1ULL << w) - 1));
+		unsigned skip = k >= c;
+		pos += skip * w;
+		k -= skip * c;
+	}
+	return pos;
+}
+
+#endif // __BITBOARD_H__
@@ -0,0 +1,236 @@
+/*
+ * Copyright (c) 2025 Benny Meisels <benny.meisels@gmail.com>
+ *                    Rani Hod <rani.hod@gmail.com>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/sys/printk.h>
+
+#include "bitboard.h"
+#include "blocks.h"
+#include "game.h"
+#include "replay.h"
+#include "screen.h"
+
+// a piece in one rotation
+struct blocks_shape_t {
+	uint32_t mask;			// cells, from the bottom right
+	uint8_t width, height;
+	uint8_t row, col;		// of the mask in the rotation box
+};
+
+// rotated clockwise within a 4x4 (I), 2x2 (O) or 3x3 box
+static const struct blocks_shape_t blocks_shapes[][4] = {
+	{ { 0x0000000F, 4, 1, 2, 0 }, { 0x01010101, 1, 4, 0, 1 },	// I
+	  { 0x0000000F, 4, 1, 1, 0 }, { 0x01010101, 1, 4, 0, 2 } },
+	{ { 0x00000303, 2, 2, 0, 0 }, { 0x00000303, 2, 2, 0, 0 },	// O
+	  { 0x00000303, 2, 2, 0, 0 }, { 0x00000303, 2, 2, 0, 0 } },
+	{ { 0x00000207, 3, 2, 1, 0 }, { 0x00020302, 2, 3, 0, 0 },	// T
+	  { 0x00000702, 3, 2, 0, 0 }, { 0x00010301, 2, 3, 0, 1 } },
+	{ { 0x00000306, 3, 2, 1, 0 }, { 0x00020301, 2, 3, 0, 0 },	// S
+	  { 0x00000306, 3, 2, 0, 0 }, { 0x00020301, 2, 3, 0, 1 } },
+	{ { 0x00000603, 3, 2, 1, 0 }, { 0x00010302, 2, 3, 0, 0 },	// Z
+	  { 0x00000603, 3, 2, 0, 0 }, { 0x00010302, 2, 3, 0, 1 } },
+	{ { 0x00000407, 3, 2, 1, 0 }, { 0x00030202, 2, 3, 0, 0 },	// J
+	  { 0x00000701, 3, 2, 0, 0 }, { 0x00010103, 2, 3, 0, 1 } },
+	{ { 0x00000107, 3, 2, 1, 0 }, { 0x00020203, 2, 3, 0, 0 },	// L
+	  { 0x00000704, 3, 2, 0, 0 }, { 0x00030101, 2, 3, 0, 1 } },
+};
+
+// points by rows cleared at once
+static const uint8_t blocks_points[] = { 0, 1, 3, 5, 8 };
+
+// the piece's cells moved by rows, cols and turns, or 0 if they hit the
+// stack or leave the board
+static uint64_t blocks_fit(const struct blocks_data_t *bd, int rows, int cols,
+	unsigned turns)
+{
+	const struct blocks_shape_t *s = &blocks_shapes[bd->piece][(bd->rotation + turns) & 3];
+	int row = bd->box_row + rows + s->row;
+	int col = bd->box_col + cols + s->col;
+	if (row < 0 || col < 0 || row + s->height > 8 || col + s->width > 8)
+		return 0;
+	uint64_t cells = (uint64_t)s->mask << BB_POS(row, col);
+	return (bd->stack & cells) ? 0 : cells;
+}
+
+static bool blocks_move(struct blocks_data_t *bd, int rows, int cols, unsigned turns)
+{
+	if ( ! blocks_fit(bd, rows, cols, turns))
+		return false;
+	bd->box_row += rows;
+	bd->box_col += cols;
+	bd->rotation = (bd->rotation + turns) & 3;
+	return true;
+}
+
+// a move of a resting piece restarts the lock delay, a few times
+static void blocks_moved(struct blocks_data_t *bd)
+{
+	if (bd->lock_ticks && bd->lock_resets < BLOCKS_LOCK_RESETS) {
+		bd->lock_ticks = 0;
+		++bd->lock_resets;
+	}
+}
+
+// rotate, or kick off a wall or the stack by a column
+static bool blocks_rotate(struct blocks_data_t *bd, unsigned turns)
+{
+	return blocks_move(bd, 0, 0, turns) || blocks_move(bd, 0, 1, turns) ||
+		blocks_move(bd, 0, -1, turns);
+}
+
+static unsigned blocks_fall_ticks(const struct blocks_data_t *bd)
+{
+	unsigned level = bd->lines / BLOCKS_LINES_PER_LEVEL;
+	return MAX(BLOCKS_FALL_TICKS - 4 * (int)level, BLOCKS_FALL_MIN_TICKS);
+}
+
+// the next piece at the top center; false if it does not fit
+static bool blocks_spawn(struct blocks_data_t *bd)
+{
+	bd->piece = replay_rand32() % ARRAY_SIZE(blocks_shapes);
+	bd->rotation = 0;
+	const struct blocks_shape_t *s = &blocks_shapes[bd->piece][0];
+	bd->box_row = 8 - s->height - s->row;
+	bd->box_col = (8 - s->width) / 2 - s->col;
+	bd->fall_ticks = blocks_fall_ticks(bd);
+	bd->lock_ticks = 0;
+	bd->lock_resets = 0;
+	return blocks_fit(bd, 0, 0, 0) != 0;
+}
+
+// all rows with 8 cells
+static uint64_t blocks_full_rows(uint64_t x)
+{
+	x &= x >> 4;
+	x &= x >> 2;
+	x &= x >> 1;	// bit 0 of a row: the and of its 8 bits
+	return (x & BB_COLUMN_0) * 0xFF;
+}
+
+// drop the full rows, moving the ones above down; no branches on the rows
+static uint64_t blocks_compact(uint64_t stack, uint64_t full)
+{
+	uint64_t out = 0;
+	unsigned k = 0;
+	for (unsigned r = 0; r < 8; r++) {
+		uint64_t keep = ! (full & BB_ROW(r));
+		out |= (((stack >> (8 * r)) & BB_ROW_0) * keep) << (8 * k);
+		k += keep;
+	}
+	return out;
+}
+
+static void blocks_input(void *state, char btn)
+{
+	struct blocks_data_t *bd = state;
+	if (bd->clear_ticks)
+		return;
+	switch (btn) {
+		case 'L':
+			if (blocks_move(bd, 0, 1, 0)) blocks_moved(bd);
+			break;
+		case 'R':
+			if (blocks_move(bd, 0, -1, 0)) blocks_moved(bd);
+			break;
+		case 'A':
+			if (blocks_rotate(bd, 1)) blocks_moved(bd);
+			break;
+		case 'B':
+			if (blocks_rotate(bd, 3)) blocks_moved(bd);
+			break;
+		case 'D':
+			if (blocks_move(bd, -1, 0, 0))
+				bd->fall_ticks = blocks_fall_ticks(bd);
+			break;
+		case 'U':
+			// at most 7 rows, then lock on the next update
+			for (unsigned i = 0; i < 7; i++)
+				blocks_move(bd, -1, 0, 0);
+			bd->lock_ticks = BLOCKS_LOCK_TICKS;
+			bd->lock_resets = BLOCKS_LOCK_RESETS;
+			break;
+	}
+}
+
+static bool blocks_update(void *state)
+{
+	struct blocks_data_t *bd = state;
+	if (bd->clear_ticks) {
+		if (--bd->clear_ticks)
+			return true;
+		bd->stack = blocks_compact(bd->stack, bd->clearing);
+		bd->clearing = 0;
+		return blocks_spawn(bd);
+	}
+
+	// gravity, then the lock delay once resting on something
+	if ( ! --bd->fall_ticks) {
+		blocks_move(bd, -1, 0, 0);
+		bd->fall_ticks = blocks_fall_ticks(bd);
+	}
+	if (blocks_fit(bd, -1, 0, 0)) {
+		bd->lock_ticks = 0;
+		return true;
+	}
+	if (++bd->lock_ticks < BLOCKS_LOCK_TICKS)
+		return true;
+
+	bd->stack |= blocks_fit(bd, 0, 0, 0);
+	uint64_t full = blocks_full_rows(bd->stack);
+	if ( ! full)
+		return blocks_spawn(bd);
+	unsigned rows = bb_count(full) / 8;
+	bd->lines += rows;
+	bd->points += blocks_points[rows];
+	printk("[%s] %u rows; lines=%u points=%u\n", __func__, rows, bd->lines, bd->points);
+	bd->clearing = full;
+	bd->clear_ticks = BLOCKS_CLEAR_TICKS;
+	return true;
+}
+
+static void blocks_render(const void *state)
+{
+	const struct blocks_data_t *bd = state;
+	screen_begin();
+	screen_set(bd->stack | (bd->clear_ticks ? 0 : blocks_fit(bd, 0, 0, 0)));
+	if (bd->clearing)
+		screen_mask_blink(bd->clearing, true);
+	screen_commit();
+}
+
+static uint32_t blocks_tick_ms(const void *state)
+{
+	return BLOCKS_TICK_MS;
+}
+
+static const struct game_t blocks = {
+	.name		= "blocks",
+	.buttons	= "L+R+D+UAB",
+	.input		= blocks_input,
+	.update		= blocks_update,
+	.render		= blocks_render,
+	.tick_ms	= blocks_tick_ms,
+};
+
+unsigned play_blocks()
+{
+	printk("[%s] new game\n", __func__);
+
+	struct blocks_data_t bd = {0};
+	blocks_spawn(&bd);
+	game_run(&blocks, &bd, GAME_REALTIME);
+
+	// show the stack that ended it
+	screen_begin();
+	screen_set(0);
+	screen_mask_blink(bd.stack, false);
+	screen_commit();
+	k_msleep(1500);
+	screen_set(0);
+
+	printk("[%s] game ended, score=%u lines=%u\n", __func__, bd.points, bd.lines);
+	return bd.points;
+}
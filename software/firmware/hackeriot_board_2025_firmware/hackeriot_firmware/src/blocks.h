@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) 2025 Benny Meisels <benny.meisels@gmail.com>
+ *                    Rani Hod <rani.hod@gmail.com>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef __BLOCKS_H__
+#define __BLOCKS_H__
+
+#include <zephyr/kernel.h>
+
+// Falling blocks on the 8x8 screen. The stack is a bitboard, and each
+// rotation of each piece a precomputed mask at the bottom right, so a
+// move is a bounds check and one AND with the stack. Full rows are found
+// and compacted with word operations; every tick costs the same however
+// high the stack is. L/R move, D drops a row, U drops all the way, A and
+// B rotate clockwise and counterclockwise.
+
+#define BLOCKS_TICK_MS			20
+#define BLOCKS_FALL_TICKS		40	// per row at level 0, 800 ms
+#define BLOCKS_FALL_MIN_TICKS	4	// at the top level
+#define BLOCKS_LOCK_TICKS		25	// resting before a piece locks
+#define BLOCKS_LOCK_RESETS		8	// moves that restart the lock delay
+#define BLOCKS_CLEAR_TICKS		25	// full rows blink before they go
+#define BLOCKS_LINES_PER_LEVEL	4
+
+struct blocks_data_t {
+	uint64_t stack;			// locked cells
+	uint64_t clearing;		// full rows, blinking
+	uint16_t points;
+	uint16_t lines;
+	uint8_t piece;			// index into blocks_shapes
+	uint8_t rotation;		// 0 to 3, clockwise
+	int8_t box_row, box_col;	// bottom right of the piece's rotation box
+	uint8_t fall_ticks;		// until the next gravity step
+	uint8_t lock_ticks;		// resting so far
+	uint8_t lock_resets;
+	uint8_t clear_ticks;	// left to blink the full rows
+};
+
+unsigned play_blocks();
+
+#endif // __BLOCKS_H__
@@ -6,67 +6,232 @@
  */
 
 #include <zephyr/input/input.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/barrier.h>
 #include <zephyr/sys/printk.h>
 
 #include "buttons.h"
+#include "gesture.h"
+#include "latency.h"
+#include "replay.h"
 
-K_PIPE_DEFINE(buttons_pipe, 16, 1); // 16 bytes, not aligned
+#define BUTTONS_CHARS "ULDRABZX" // by enum buttons_key
 
-char buttons_get(const char *filter, k_timeout_t timeout)
+BUILD_ASSERT((BUTTONS_RING_SIZE & (BUTTONS_RING_SIZE - 1)) == 0,
+    "BUTTONS_RING_SIZE must be a power of 2");
+
+// Single-producer, single-consumer ring: the input callback only writes
+// buttons_head, the consuming thread only buttons_tail. Both count events
+// forever; the difference is the fill level.
+static struct buttons_event_t buttons_ring[BUTTONS_RING_SIZE];
+static atomic_t buttons_head;
+static atomic_t buttons_tail;
+static K_SEM_DEFINE(buttons_wake, 0, 1);
+
+// consumer side: one event pushed back by buttons_unread()
+static struct buttons_event_t buttons_pushback;
+static bool buttons_pushback_valid;
+
+static atomic_t buttons_overflows;
+
+char buttons_event_char(const struct buttons_event_t *evt)
+{
+    char ch = BUTTONS_CHARS[MIN(evt->key, BUTTON_END - 1)];
+    return evt->pressed ? ch : (char)(ch ^ BIT(5)); // lowercase = button release
+}
+
+uint32_t buttons_mask(const char *filter)
+{
+    if ( ! filter)
+        return BUTTONS_ALL;
+
+    uint32_t mask = 0;
+    unsigned key = BUTTON_END;
+    for (; *filter; filter++) {
+        if (*filter == '+') {
+            if (key < BUTTON_END)
+                mask |= BUTTONS_MASK_REPEAT(key);
+            continue;
+        }
+        const char *p = strchr(BUTTONS_CHARS, *filter & ~BIT(5)); // upper case
+        if ( ! p) continue;
+        key = p - BUTTONS_CHARS;
+        mask |= (*filter & BIT(5)) ? BUTTONS_MASK_RELEASE(key) : BUTTONS_MASK_PRESS(key);
+    }
+    return mask;
+}
+
+// Skipped events stay queued for reads with other filters. Once the ring
+// is half full, the skipped releases, repeats and long-presses go, so a
+// reader that never takes them (most menus and releases) leaves room for
+// new presses; presses themselves are kept until buttons_clear().
+static void buttons_trim()
+{
+    atomic_val_t tail = atomic_get(&buttons_tail);
+    atomic_val_t head = atomic_get(&buttons_head);
+    if ((uint32_t)(head - tail) <= BUTTONS_RING_SIZE / 2)
+        return;
+    barrier_dmem_fence_full(); // read the events after head
+
+    // move the presses up against head, in order; the slots are ours
+    atomic_val_t to = head;
+    for (atomic_val_t from = head; from != tail; ) {
+        const struct buttons_event_t *e = &buttons_ring[--from & (BUTTONS_RING_SIZE - 1)];
+        if (e->gesture == BUTTONS_RAW && e->pressed && --to != from)
+            buttons_ring[to & (BUTTONS_RING_SIZE - 1)] = *e;
+    }
+    barrier_dmem_fence_full(); // done with the slots
+    atomic_set(&buttons_tail, to);
+}
+
+// scan queued events from the oldest; when consume is set, the match is
+// removed and the events before it are kept, in order
+static bool buttons_scan(uint32_t mask, struct buttons_event_t *evt,
+    bool consume)
+{
+    if (buttons_pushback_valid && (buttons_event_mask(&buttons_pushback) & mask)) {
+        *evt = buttons_pushback;
+        if (consume) {
+            buttons_pushback_valid = false;
+            latency_read(evt);
+        }
+        return true;
+    }
+
+    bool found = false;
+    atomic_val_t tail = atomic_get(&buttons_tail);
+    atomic_val_t head = atomic_get(&buttons_head);
+    barrier_dmem_fence_full(); // read the events after head
+    for (atomic_val_t i = tail; i != head; i++) {
+        const struct buttons_event_t *e = &buttons_ring[i & (BUTTONS_RING_SIZE - 1)];
+        if ( ! (buttons_event_mask(e) & mask))
+            continue;
+        *evt = *e;
+        found = true;
+        if (consume) {
+            latency_read(evt);
+            // close the gap; the slots up to the match are the consumer's
+            for (atomic_val_t j = i; j != tail; j--)
+                buttons_ring[j & (BUTTONS_RING_SIZE - 1)] =
+                    buttons_ring[(j - 1) & (BUTTONS_RING_SIZE - 1)];
+            barrier_dmem_fence_full(); // done with the slot
+            atomic_set(&buttons_tail, tail + 1);
+        }
+        break;
+    }
+    if (consume)
+        buttons_trim();
+    return found;
+}
+
+static bool buttons_wait(uint32_t mask, k_timeout_t timeout,
+    struct buttons_event_t *evt)
 {
     k_timepoint_t tp = sys_timepoint_calc(timeout);
-    uint8_t ch;
-    while (1) {
-        int res = k_pipe_read(&buttons_pipe, &ch, 1, sys_timepoint_timeout(tp));
-        if (res == -EAGAIN) // timeout expired
-            return 0;
-        if (res == -EPIPE || res == -ECANCELED) {
-            printk("Cannot read from pipe; it is %s\n", 
-                res == -EPIPE ? "closed" : "reset");
-            return 0;
+    while ( ! buttons_scan(mask, evt, true)) {
+        // -EAGAIN once the timeout expires, -EBUSY for K_NO_WAIT
+        if (k_sem_take(&buttons_wake, sys_timepoint_timeout(tp)) != 0)
+            return buttons_scan(mask, evt, true);
+    }
+    return true;
+}
+
+bool buttons_get_event(uint32_t mask, k_timeout_t timeout,
+    struct buttons_event_t *evt)
+{
+    k_timeout_t wait;
+    int replayed = replay_next(mask, timeout, evt, &wait);
+    if (replayed >= 0) {
+        // a press while replaying in real time takes over
+        struct buttons_event_t live;
+        if ( ! replay_full_speed() &&
+            buttons_wait(BUTTONS_ALL_PRESSES, wait, &live)) {
+            replay_take_over();
+            return false;
         }
-        if (res == 1 && (! filter || strchr(filter, ch)))
-            return ch;
+        return replayed;
     }
-    // never reached
+
+    bool got = buttons_wait(mask, timeout, evt);
+    replay_record(got ? evt : NULL);
+    return got;
+}
+
+bool buttons_peek_event(uint32_t mask, struct buttons_event_t *evt)
+{
+    return buttons_scan(mask, evt, false);
+}
+
+// push evt back to be read again first; room for one
+int buttons_unread(const struct buttons_event_t *evt)
+{
+    if (buttons_pushback_valid)
+        return -ENOSPC;
+    buttons_pushback = *evt;
+    buttons_pushback_valid = true;
+    return 0;
+}
+
+char buttons_get(const char *filter, k_timeout_t timeout)
+{
+    struct buttons_event_t evt;
+    if ( ! buttons_get_event(buttons_mask(filter), timeout, &evt))
+        return 0;
+    return buttons_event_char(&evt);
 }
 
 void buttons_clear()
 {
-    uint8_t ch;
-    int res;
-    do {
-        res = k_pipe_read(&buttons_pipe, &ch, 1, K_NO_WAIT);
-        if (res == -EPIPE || res == -ECANCELED) {
-            printk("Cannot read from pipe; it is %s\n", 
-                res == -EPIPE ? "closed" : "reset");
-        }
-    } while (res == 1);
+    buttons_pushback_valid = false;
+    atomic_set(&buttons_tail, atomic_get(&buttons_head));
+
+    atomic_val_t overflows = atomic_set(&buttons_overflows, 0);
+    if (overflows)
+        printk("[%s] %ld events lost to a full ring\n", __func__, (long)overflows);
+}
+
+// push one event; called by the input callback only
+static void buttons_push(const struct buttons_event_t *e)
+{
+    atomic_val_t head = atomic_get(&buttons_head);
+    if ((uint32_t)(head - atomic_get(&buttons_tail)) >= BUTTONS_RING_SIZE) {
+        atomic_inc(&buttons_overflows); // reported by buttons_clear()
+        return;
+    }
+    buttons_ring[head & (BUTTONS_RING_SIZE - 1)] = *e;
+    barrier_dmem_fence_full(); // publish the event before head
+    atomic_set(&buttons_head, head + 1);
 }
 
-void buttons_pipe_cb(struct input_event *evt, void *)
+void buttons_input_cb(struct input_event *evt, void *)
 {
-    char ch;
+    struct buttons_event_t e = {
+        .cycles = k_cycle_get_32(),
+        .pressed = evt->value != 0,
+    };
+    switch (evt->value) {
+        case GESTURE_VALUE_REPEAT:  e.gesture = BUTTONS_REPEAT; break;
+        case GESTURE_VALUE_LONG:    e.gesture = BUTTONS_LONG; break;
+        default:                    e.gesture = BUTTONS_RAW;
+    }
 	switch (evt->code) {
-		case INPUT_BTN_DPAD_UP:		ch = 'U'; break;
-		case INPUT_BTN_DPAD_LEFT:	ch = 'L'; break;
-		case INPUT_BTN_DPAD_DOWN:	ch = 'D'; break;
-		case INPUT_BTN_DPAD_RIGHT:	ch = 'R'; break;
-		case INPUT_BTN_A:			ch = 'A'; break;
-		case INPUT_BTN_B:			ch = 'B'; break;
-        default:                    ch = 'Z';
+		case INPUT_BTN_DPAD_UP:		e.key = BUTTON_UP; break;
+		case INPUT_BTN_DPAD_LEFT:	e.key = BUTTON_LEFT; break;
+		case INPUT_BTN_DPAD_DOWN:	e.key = BUTTON_DOWN; break;
+		case INPUT_BTN_DPAD_RIGHT:	e.key = BUTTON_RIGHT; break;
+		case INPUT_BTN_A:			e.key = BUTTON_A; break;
+		case INPUT_BTN_B:			e.key = BUTTON_B; break;
+        default:                    e.key = BUTTON_OTHER;
 	}
-	if ( ! evt->value)
-        ch ^= BIT(6); // lowercase = button release
-
-    int res = k_pipe_write(&buttons_pipe, &ch, 1, K_NO_WAIT);
-    if (res != 1) {
-        printk("Cannot write '%c' to pipe; it is ", ch);
-        if (res == -ECANCELED)      printk("reset\n");
-        else if (res == -EAGAIN)    printk("full\n");
-        else if (res == -EPIPE)     printk("closed\n");
-        else                        printk("error %d\n", res);
-    }
+    if (e.gesture == BUTTONS_RAW)
+        latency_input(e.cycles, e.pressed);
+
+    struct buttons_event_t out[GESTURE_MAX_OUT];
+    unsigned n = gesture_input(&e, out);
+    for (unsigned i = 0; i < n; i++)
+        buttons_push(&out[i]);
+    if (n)
+        k_sem_give(&buttons_wake);
 }
 
-INPUT_CALLBACK_DEFINE(NULL, buttons_pipe_cb, NULL);
+INPUT_CALLBACK_DEFINE(NULL, buttons_input_cb, NULL);
@@ -10,6 +10,73 @@
 
 #include <zephyr/kernel.h>
 
+#define BUTTONS_RING_SIZE   32 // events, power of 2
+
+enum buttons_key {
+    BUTTON_UP = 0,
+    BUTTON_LEFT,
+    BUTTON_DOWN,
+    BUTTON_RIGHT,
+    BUTTON_A,
+    BUTTON_B,
+    BUTTON_OTHER,
+    BUTTON_AB,  // chord, see gesture.h
+    BUTTON_END /* keep last */
+};
+
+enum buttons_gesture {
+    BUTTONS_RAW = 0,    // press or release
+    BUTTONS_REPEAT,     // auto-repeat of a held key
+    BUTTONS_LONG,       // long-press of a held key
+};
+
+// event filters: one bit per key and kind of event
+#define BUTTONS_MASK_PRESS(key)     BIT(key)
+#define BUTTONS_MASK_RELEASE(key)   BIT(8 + (key))
+#define BUTTONS_MASK_REPEAT(key)    BIT(16 + (key))
+#define BUTTONS_MASK_LONG(key)      BIT(24 + (key))
+#define BUTTONS_ALL_PRESSES         (BIT(BUTTON_END) - 1)
+#define BUTTONS_ALL_RELEASES        (BUTTONS_ALL_PRESSES << 8)
+#define BUTTONS_ALL_REPEATS         (BUTTONS_ALL_PRESSES << 16)
+#define BUTTONS_ALL_LONGS           (BUTTONS_ALL_PRESSES << 24)
+#define BUTTONS_ALL                 (BUTTONS_ALL_PRESSES | BUTTONS_ALL_RELEASES | \
+                                     BUTTONS_ALL_REPEATS | BUTTONS_ALL_LONGS)
+
+struct buttons_event_t {
+    uint32_t    cycles;     // k_cycle_get_32() when the input event arrived
+    uint8_t     key;        // actual type: enum buttons_key
+    bool        pressed;    // false for a release
+    uint8_t     gesture;    // actual type: enum buttons_gesture
+};
+
+static inline uint32_t buttons_event_mask(const struct buttons_event_t *evt)
+{
+    switch (evt->gesture) {
+        case BUTTONS_REPEAT:    return BUTTONS_MASK_REPEAT(evt->key);
+        case BUTTONS_LONG:      return BUTTONS_MASK_LONG(evt->key);
+        default:
+            return evt->pressed ? BUTTONS_MASK_PRESS(evt->key) : BUTTONS_MASK_RELEASE(evt->key);
+    }
+}
+
+// 'U', 'L', 'D', 'R', 'A', 'B', 'Z' (other) or 'X' (A+B chord) on press,
+// repeat or long-press; lowercase on release
+char buttons_event_char(const struct buttons_event_t *evt);
+
+// filter from such characters; NULL means all events. A '+' after a key
+// also takes its auto-repeats, e.g. "U+D+AB".
+uint32_t buttons_mask(const char *filter);
+
+// Events are consumed by a single thread. Reading takes the oldest event
+// in the filter and leaves the others queued for reads with other
+// filters; past half the ring, only the presses among them. Presses are
+// lost only to a full ring, or to buttons_clear(), which each screen
+// calls so that it starts with only what is pressed on it.
+bool buttons_get_event(uint32_t mask, k_timeout_t timeout,
+    struct buttons_event_t *evt);
+bool buttons_peek_event(uint32_t mask, struct buttons_event_t *evt);
+int buttons_unread(const struct buttons_event_t *evt);
+
 char buttons_get(const char *filter, k_timeout_t timeout);
 void buttons_clear();
 
@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2025 Benny Meisels <benny.meisels@gmail.com>
+ *                    Rani Hod <rani.hod@gmail.com>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/drivers/eeprom.h>
+#include <zephyr/sys/printk.h>
+
+#include "fontpack.h"
+#include "persist.h"
+
+struct fontpack_header_t {
+	uint32_t	magic;
+	uint8_t		version;
+	uint8_t		n_ranges;
+	uint16_t	size;		// whole pack, in bytes
+	uint32_t	crc;		// CRC-32 of the ranges and glyphs
+} __packed;
+
+BUILD_ASSERT(sizeof(struct fontpack_header_t) == FONTPACK_HEADER_SIZE);
+
+struct fontpack_range_t {
+	uint16_t	first;		// first code point
+	uint16_t	count;		// number of consecutive code points
+	uint16_t	offset;		// of the first glyph, from the pack start
+} __packed;
+
+static const struct device *fontpack_eeprom;
+static struct fontpack_range_t ranges[FONTPACK_MAX_RANGES];
+static uint8_t n_ranges;
+
+static struct fontpack_cache_t {
+	uint32_t	last_use;	// 0 = empty
+	uint16_t	cp;
+	uint8_t		glyph[FONTPACK_GLYPH_SIZE];
+} cache[FONTPACK_CACHE];
+
+void fontpack_init(const struct device *eeprom)
+{
+	fontpack_eeprom = eeprom;
+	n_ranges = 0;
+
+	struct fontpack_header_t hdr;
+	int rc = eeprom_read(eeprom, EEPROM_FONT_OFFSET, &hdr, sizeof(hdr));
+	if (rc < 0) {
+		printk("[%s] header read error; code=%d.\n", __func__, rc);
+		return;
+	}
+	if (hdr.magic != FONTPACK_MAGIC || hdr.version != FONTPACK_VERSION ||
+		hdr.n_ranges > FONTPACK_MAX_RANGES ||
+		hdr.size > EEPROM_FONT_SIZE) {
+		printk("[%s] no font pack found.\n", __func__);
+		return;
+	}
+	rc = eeprom_read(eeprom, EEPROM_FONT_OFFSET + sizeof(hdr), ranges,
+		hdr.n_ranges * sizeof(ranges[0]));
+	if (rc < 0) {
+		printk("[%s] range read error; code=%d.\n", __func__, rc);
+		return;
+	}
+	n_ranges = hdr.n_ranges;
+	printk("Font pack: %u ranges, %u bytes.\n", n_ranges, hdr.size);
+}
+
+int fontpack_get(uint32_t cp, uint8_t glyph[FONTPACK_GLYPH_SIZE])
+{
+	static uint32_t use_count = 0;
+
+	// find the range without touching the EEPROM
+	const struct fontpack_range_t *range = NULL;
+	for (unsigned i = 0; i < n_ranges; i++) {
+		if (cp >= ranges[i].first && cp - ranges[i].first < ranges[i].count) {
+			range = &ranges[i];
+			break;
+		}
+	}
+	if ( ! range)
+		return -ENOENT;
+
+	// cache lookup, remembering the least recently used entry
+	struct fontpack_cache_t *lru = &cache[0];
+	for (unsigned i = 0; i < ARRAY_SIZE(cache); i++) {
+		struct fontpack_cache_t *entry = &cache[i];
+		if (entry->last_use && entry->cp == cp) {
+			entry->last_use = ++use_count;
+			memcpy(glyph, entry->glyph, FONTPACK_GLYPH_SIZE);
+			return (glyph[0] & FONTPACK_WIDTH) ? 0 : -ENOENT;
+		}
+		if (entry->last_use < lru->last_use)
+			lru = entry;
+	}
+
+	int rc = eeprom_read(fontpack_eeprom, EEPROM_FONT_OFFSET + range->offset +
+		(cp - range->first) * FONTPACK_GLYPH_SIZE, lru->glyph, FONTPACK_GLYPH_SIZE);
+	if (rc < 0) {
+		printk("[%s] read error; cp=%04x code=%d.\n", __func__, cp, rc);
+		lru->last_use = 0;
+		return rc;
+	}
+	lru->cp = cp;
+	lru->last_use = ++use_count;
+	memcpy(glyph, lru->glyph, FONTPACK_GLYPH_SIZE);
+	return (glyph[0] & FONTPACK_WIDTH) ? 0 : -ENOENT;
+}
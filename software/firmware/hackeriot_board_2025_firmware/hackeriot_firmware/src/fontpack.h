@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) 2025 Benny Meisels <benny.meisels@gmail.com>
+ *                    Rani Hod <rani.hod@gmail.com>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef __FONTPACK_H__
+#define __FONTPACK_H__
+
+#include <zephyr/kernel.h>
+
+/*
+ * Extra glyphs stored in the EEPROM at EEPROM_FONT_OFFSET, built by
+ * fontpack/mkfontpack.py and written by the installer firmware in
+ * fontpack/, so the game firmware keeps no copy. Layout (little endian):
+ *   header: magic (u32), version (u8), n_ranges (u8), size (u16),
+ *           crc (u32, CRC-32 of the rest of the pack)
+ *   ranges: first code point (u16), count (u16), offset of first glyph (u16)
+ *   glyphs: FONTPACK_GLYPH_SIZE bytes each, consecutive code points per range
+ * A glyph is width | flags, then 8 columns like the built-in font.
+ * The range table is kept in RAM, so lookups cost at most one glyph read.
+ */
+#define FONTPACK_MAGIC          0x544E4648UL /* 'HFNT' */
+#define FONTPACK_VERSION        2
+#define FONTPACK_HEADER_SIZE    12
+#define FONTPACK_MAX_RANGES     12
+#define FONTPACK_CACHE          12  // glyphs cached in RAM, LRU
+#define FONTPACK_GLYPH_SIZE     9
+
+#define FONTPACK_WIDTH          0x0F
+#define FONTPACK_COMBINING      0x80    // overlaid on the preceding glyph
+#define FONTPACK_ALIGN_START    0x40    // combining mark at the left edge
+#define FONTPACK_ALIGN_END      0x20    // combining mark at the right edge
+
+void fontpack_init(const struct device *eeprom);
+
+// copies the glyph for code point cp; returns 0, or -ENOENT if absent
+int fontpack_get(uint32_t cp, uint8_t glyph[FONTPACK_GLYPH_SIZE]);
+
+#endif // __FONTPACK_H__
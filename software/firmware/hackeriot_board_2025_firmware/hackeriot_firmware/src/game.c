@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2025 Benny Meisels <benny.meisels@gmail.com>
+ *                    Rani Hod <rani.hod@gmail.com>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/sys/printk.h>
+
+#include "buttons.h"
+#include "game.h"
+#include "replay.h"
+#include "stats.h"
+
+unsigned game_run(const struct game_t *game, void *state, enum game_mode mode)
+{
+	bool headless = (mode == GAME_HEADLESS);
+	struct stats_hist_t late_us = STATS_HIST_INIT(6); // tick start past its deadline
+	unsigned ticks = 0, overruns = 0;
+
+	if ( ! headless) {
+		buttons_clear(); // presses left from the menu do not steer
+		game->render(state);
+	}
+	int64_t deadline = k_uptime_ticks();
+	while (1) {
+		// a replay at full speed keeps rendering but skips the waits
+		int64_t period = k_ms_to_ticks_ceil64(game->tick_ms(state));
+		deadline += period;
+		if ( ! headless && ! replay_full_speed()) {
+			k_sleep(K_TIMEOUT_ABS_TICKS(deadline));
+			int64_t late = k_uptime_ticks() - deadline;
+			stats_hist_add(&late_us, k_ticks_to_us_floor32(late));
+			if (late > period) {
+				++overruns;
+				deadline += late;
+			}
+		}
+
+		// everything pressed during the last tick, in order
+		if ( ! headless) {
+			char btn;
+			while ((btn = buttons_get(game->buttons, K_NO_WAIT)))
+				game->input(state, btn);
+		}
+
+		++ticks;
+		if ( ! game->update(state))
+			break;
+		if ( ! headless)
+			game->render(state);
+	}
+
+	printk("[%s] %s: %u ticks, %u overruns\n", __func__, game->name, ticks, overruns);
+	if ( ! headless)
+		stats_hist_print("tick late us", &late_us);
+	return ticks;
+}
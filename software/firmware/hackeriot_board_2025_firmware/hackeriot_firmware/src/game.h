@@ -0,0 +1,36 @@
+/*
+ * Copyright (c) 2025 Benny Meisels <benny.meisels@gmail.com>
+ *                    Rani Hod <rani.hod@gmail.com>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef __GAME_H__
+#define __GAME_H__
+
+#include <zephyr/kernel.h>
+
+// Fixed-timestep game runtime. Ticks run on absolute deadlines, tick_ms()
+// apart, so neither presses nor a slow update change the pace. Each tick
+// drains the buttons queued since the last one into input(), then calls
+// update() once and render() once. A tick that starts over a tick late
+// counts as an overrun, and the missed ticks are dropped rather than
+// rushed.
+struct game_t {
+	const char *name;
+	const char *buttons;	// input filter, see buttons_get()
+	void (*input)(void *state, char btn);
+	bool (*update)(void *state);	// false ends the game
+	void (*render)(const void *state);
+	uint32_t (*tick_ms)(const void *state);	// the speed curve
+};
+
+enum game_mode {
+	GAME_REALTIME = 0,
+	GAME_HEADLESS,		// no waits, input or rendering; for benchmarks
+};
+
+// returns the number of ticks run
+unsigned game_run(const struct game_t *game, void *state, enum game_mode mode);
+
+#endif // __GAME_H__
@@ -0,0 +1,274 @@
+/*
+ * Copyright (c) 2025 Benny Meisels <benny.meisels@gmail.com>
+ *                    Rani Hod <rani.hod@gmail.com>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <limits.h>
+
+#include <zephyr/input/input.h>
+#include <zephyr/sys/printk.h>
+
+#include "gesture.h"
+
+#define GESTURE_SYMBOLS     BUTTON_OTHER    // sequences are over real keys
+#define GESTURE_CHORD_MS    150             // both keys pressed within
+
+// input codes, to report synthetic repeat and long-press events
+static const uint16_t key_codes[BUTTON_OTHER] = {
+    [BUTTON_UP]     = INPUT_BTN_DPAD_UP,
+    [BUTTON_LEFT]   = INPUT_BTN_DPAD_LEFT,
+    [BUTTON_DOWN]   = INPUT_BTN_DPAD_DOWN,
+    [BUTTON_RIGHT]  = INPUT_BTN_DPAD_RIGHT,
+    [BUTTON_A]      = INPUT_BTN_A,
+    [BUTTON_B]      = INPUT_BTN_B,
+};
+
+// the D-pad repeats, faster the longer it is held; A and B long-press
+static struct gesture_key_t gesture_keys[BUTTON_OTHER] = {
+    [BUTTON_UP ... BUTTON_RIGHT] = {
+        .repeat_delay_ms = 400,
+        .repeat_ms = 200,
+        .repeat_min_ms = 50,
+        .repeat_accel = 80,
+    },
+    [BUTTON_A ... BUTTON_B] = {
+        .long_ms = 1000,
+    },
+};
+
+static const struct gesture_chord_t {
+    uint8_t keys;   // bits by enum buttons_key
+    uint8_t key;    // virtual key reported
+} gesture_chords[] = {
+    { BIT(BUTTON_A) | BIT(BUTTON_B), BUTTON_AB },
+};
+
+static struct k_spinlock gesture_lock;
+
+// the key held for repeats or a long-press; only the last pressed one
+static struct {
+    int8_t      key;            // -1 for none
+    bool        long_done;
+    uint16_t    interval;       // ms, the next repeat interval
+    uint32_t    long_at;        // k_uptime_get_32() deadlines
+    uint32_t    repeat_at;
+} held = { .key = -1 };
+
+static void gesture_work_func(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(gesture_work, gesture_work_func);
+
+// chords
+static uint8_t down_keys;
+static uint32_t down_cycles[BUTTON_OTHER];
+
+// Aho-Corasick automaton, as a full transition table
+static struct {
+    const uint8_t *keys;
+    uint8_t len;
+    gesture_sequence_cb_t cb;
+    void *user_data;
+} sequences[GESTURE_MAX_SEQUENCES];
+static unsigned n_sequences;
+static uint8_t ac_next[GESTURE_MAX_STATES][GESTURE_SYMBOLS];
+static uint8_t ac_out[GESTURE_MAX_STATES];  // bit i: sequence i ends here
+static uint8_t ac_state;
+
+// ms until the next repeat or long-press of the held key, -1 for none;
+// called locked
+static int gesture_next_delay(uint32_t now)
+{
+    if (held.key < 0)
+        return -1;
+    const struct gesture_key_t *cfg = &gesture_keys[held.key];
+    int delay = INT_MAX;
+    if (cfg->long_ms && ! held.long_done)
+        delay = MIN(delay, (int32_t)(held.long_at - now));
+    if (cfg->repeat_delay_ms)
+        delay = MIN(delay, (int32_t)(held.repeat_at - now));
+    return (delay == INT_MAX) ? -1 : MAX(delay, 0);
+}
+
+static void gesture_work_func(struct k_work *work)
+{
+    k_spinlock_key_t lock = k_spin_lock(&gesture_lock);
+    if (held.key < 0) {
+        k_spin_unlock(&gesture_lock, lock);
+        return;
+    }
+    const struct gesture_key_t *cfg = &gesture_keys[held.key];
+    uint32_t now = k_uptime_get_32();
+    int value = 0;
+    if (cfg->long_ms && ! held.long_done && (int32_t)(held.long_at - now) <= 0) {
+        value = GESTURE_VALUE_LONG;
+        held.long_done = true;
+    } else if (cfg->repeat_delay_ms && (int32_t)(held.repeat_at - now) <= 0) {
+        value = GESTURE_VALUE_REPEAT;
+        held.repeat_at = now + held.interval;
+        held.interval = MAX(held.interval * cfg->repeat_accel / 100, cfg->repeat_min_ms);
+    }
+    uint16_t code = key_codes[held.key];
+    int delay = gesture_next_delay(now);
+    k_spin_unlock(&gesture_lock, lock);
+
+    // through the input subsystem, so the buttons ring keeps one producer;
+    // not input_report_key(), which would turn the value into a press
+    if (value)
+        input_report(NULL, INPUT_EV_KEY, code, value, true, K_NO_WAIT);
+    if (delay >= 0)
+        k_work_reschedule(&gesture_work, K_MSEC(delay));
+}
+
+void gesture_set_key(enum buttons_key key, const struct gesture_key_t *cfg)
+{
+    if (key >= BUTTON_OTHER)
+        return;
+    k_spinlock_key_t lock = k_spin_lock(&gesture_lock);
+    gesture_keys[key] = *cfg;
+    k_spin_unlock(&gesture_lock, lock);
+}
+
+// rebuild the automaton from all sequences; called locked
+static int gesture_compile()
+{
+    unsigned n_states = 1; // the root, 0, is the empty match
+    memset(ac_next, 0, sizeof(ac_next));
+    memset(ac_out, 0, sizeof(ac_out));
+
+    // trie; 0 is "no edge" here, as no edge leads back to the root
+    for (unsigned i = 0; i < n_sequences; i++) {
+        unsigned s = 0;
+        for (unsigned j = 0; j < sequences[i].len; j++) {
+            uint8_t k = sequences[i].keys[j];
+            if ( ! ac_next[s][k]) {
+                if (n_states == GESTURE_MAX_STATES)
+                    return -ENOMEM;
+                ac_next[s][k] = n_states++;
+            }
+            s = ac_next[s][k];
+        }
+        ac_out[s] |= BIT(i);
+    }
+
+    // breadth first: each state's failure link is shallower, so missing
+    // edges can be copied from it
+    uint8_t fail[GESTURE_MAX_STATES], queue[GESTURE_MAX_STATES];
+    unsigned head = 0, tail = 0;
+    for (unsigned k = 0; k < GESTURE_SYMBOLS; k++) {
+        uint8_t t = ac_next[0][k];
+        if (t) {
+            fail[t] = 0;
+            queue[tail++] = t;
+        }
+    }
+    while (head < tail) {
+        uint8_t s = queue[head++];
+        ac_out[s] |= ac_out[fail[s]];
+        for (unsigned k = 0; k < GESTURE_SYMBOLS; k++) {
+            uint8_t t = ac_next[s][k];
+            if (t) {
+                fail[t] = ac_next[fail[s]][k];
+                queue[tail++] = t;
+            } else
+                ac_next[s][k] = ac_next[fail[s]][k];
+        }
+    }
+    ac_state = 0;
+    return 0;
+}
+
+int gesture_add_sequence(const uint8_t *keys, unsigned len,
+    gesture_sequence_cb_t cb, void *user_data)
+{
+    for (unsigned j = 0; j < len; j++)
+        if (keys[j] >= GESTURE_SYMBOLS)
+            return -EINVAL;
+
+    k_spinlock_key_t lock = k_spin_lock(&gesture_lock);
+    int rc = -ENOMEM;
+    if (n_sequences < GESTURE_MAX_SEQUENCES) {
+        sequences[n_sequences].keys = keys;
+        sequences[n_sequences].len = len;
+        sequences[n_sequences].cb = cb;
+        sequences[n_sequences].user_data = user_data;
+        ++n_sequences;
+        rc = gesture_compile();
+        if (rc < 0) {
+            --n_sequences;
+            gesture_compile(); // as before
+        }
+    }
+    k_spin_unlock(&gesture_lock, lock);
+    if (rc < 0)
+        printk("[%s] cannot add sequence; code=%d.\n", __func__, rc);
+    return rc;
+}
+
+unsigned gesture_input(const struct buttons_event_t *evt,
+    struct buttons_event_t out[GESTURE_MAX_OUT])
+{
+    unsigned n = 0;
+    int key = evt->key;
+    uint8_t matched = 0;
+    int delay = -1;
+    bool cancel = false;
+
+    k_spinlock_key_t lock = k_spin_lock(&gesture_lock);
+    if (evt->gesture != BUTTONS_RAW) {
+        // a repeat or long-press may race with the release
+        if (held.key == key)
+            out[n++] = *evt;
+    } else if (key >= BUTTON_OTHER) {
+        ac_state = 0;
+        out[n++] = *evt;
+    } else if (evt->pressed) {
+        out[n++] = *evt;
+
+        ac_state = ac_next[ac_state][key];
+        matched = ac_out[ac_state];
+
+        for (unsigned i = 0; i < ARRAY_SIZE(gesture_chords); i++) {
+            uint8_t other = gesture_chords[i].keys & ~BIT(key);
+            if (other == gesture_chords[i].keys || (down_keys & other) != other)
+                continue;
+            unsigned k = __builtin_ctz(other);
+            if (k_cyc_to_ms_floor32(evt->cycles - down_cycles[k]) <= GESTURE_CHORD_MS) {
+                out[n] = *evt;
+                out[n++].key = gesture_chords[i].key;
+            }
+        }
+        down_keys |= BIT(key);
+        down_cycles[key] = evt->cycles;
+
+        const struct gesture_key_t *cfg = &gesture_keys[key];
+        held.key = (cfg->long_ms || cfg->repeat_delay_ms) ? key : -1;
+        if (held.key >= 0) {
+            uint32_t now = k_uptime_get_32();
+            held.long_done = false;
+            held.long_at = now + cfg->long_ms;
+            held.repeat_at = now + cfg->repeat_delay_ms;
+            held.interval = cfg->repeat_ms;
+            delay = gesture_next_delay(now);
+        } else
+            cancel = true;
+    } else {
+        out[n++] = *evt;
+        down_keys &= ~BIT(key);
+        if (held.key == key) {
+            held.key = -1;
+            cancel = true;
+        }
+    }
+    k_spin_unlock(&gesture_lock, lock);
+
+    if (delay >= 0)
+        k_work_reschedule(&gesture_work, K_MSEC(delay));
+    else if (cancel)
+        k_work_cancel_delayable(&gesture_work);
+
+    for (unsigned i = 0; matched; i++, matched >>= 1)
+        if (matched & 1)
+            sequences[i].cb(sequences[i].user_data);
+    return n;
+}
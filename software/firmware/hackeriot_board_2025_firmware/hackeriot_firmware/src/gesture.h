@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) 2025 Benny Meisels <benny.meisels@gmail.com>
+ *                    Rani Hod <rani.hod@gmail.com>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef __GESTURE_H__
+#define __GESTURE_H__
+
+#include <zephyr/kernel.h>
+
+#include "buttons.h"
+
+// Gestures are recognised in the input callback, in constant time per
+// event:
+// - auto-repeat and long-press, per key (timed by a delayable work item
+//   that reports synthetic input events with these values)
+// - two-button chords, reported as a press of a virtual key
+// - key sequences, all registered ones matched at once by an Aho-Corasick
+//   automaton over presses; each match calls its callback
+#define GESTURE_VALUE_REPEAT    2   // input event value, as in Linux
+#define GESTURE_VALUE_LONG      3
+
+#define GESTURE_MAX_SEQUENCES   4
+#define GESTURE_MAX_STATES      32  // automaton states, 1 + total keys
+#define GESTURE_MAX_OUT         2   // events out per event in
+
+struct gesture_key_t {
+    uint16_t    long_ms;            // hold time for a long-press, 0 for none
+    uint16_t    repeat_delay_ms;    // hold time for the first repeat, 0 for none
+    uint16_t    repeat_ms;          // then first interval
+    uint16_t    repeat_min_ms;      // fastest interval
+    uint8_t     repeat_accel;       // percent of the previous interval
+};
+
+typedef void (*gesture_sequence_cb_t)(void *user_data);
+
+void gesture_set_key(enum buttons_key key, const struct gesture_key_t *cfg);
+
+// keys must stay valid; presses of other keys in between break a sequence
+int gesture_add_sequence(const uint8_t *keys, unsigned len,
+    gesture_sequence_cb_t cb, void *user_data);
+
+// for the buttons input callback: the events to queue for evt
+unsigned gesture_input(const struct buttons_event_t *evt,
+    struct buttons_event_t out[GESTURE_MAX_OUT]);
+
+#endif // __GESTURE_H__
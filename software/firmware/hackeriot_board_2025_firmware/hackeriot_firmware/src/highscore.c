@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2025 Benny Meisels <benny.meisels@gmail.com>
+ *                    Rani Hod <rani.hod@gmail.com>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/sys/crc.h>
+#include <zephyr/sys/printk.h>
+
+#include "highscore.h"
+#include "shadow.h"
+
+BUILD_ASSERT(sizeof(struct highscore_table_t) <= EEPROM_PAGE_SIZE);
+BUILD_ASSERT(EEPROM_HS_OFFSET % EEPROM_PAGE_SIZE == 0);
+BUILD_ASSERT(EEPROM_HS_OFFSET + N_GAMES * EEPROM_PAGE_SIZE <= EEPROM_SETTINGS_OFFSET);
+
+static struct highscore_table_t tables[N_GAMES];
+
+static uint16_t highscore_crc(const struct highscore_table_t *t)
+{
+	return crc16_ccitt(0xFFFF, (const uint8_t *)t, offsetof(struct highscore_table_t, crc));
+}
+
+static void highscore_save(uint8_t game)
+{
+	tables[game].crc = highscore_crc(&tables[game]);
+	int rc = shadow_write(EEPROM_HS_OFFSET + game * EEPROM_PAGE_SIZE,
+		&tables[game], sizeof(tables[game]));
+	if (rc < 0) {
+		printk("[%s] write error; game=%u code=%d.\n", __func__, game, rc);
+	}
+}
+
+static void highscore_reset(uint8_t game)
+{
+	tables[game] = (struct highscore_table_t) {
+		.magic = HIGHSCORE_MAGIC,
+		.game = game,
+	};
+	highscore_save(game);
+}
+
+void highscore_init()
+{
+	// read through the shadow, which keeps the last pages for the saves
+	for (unsigned i = 0; i < N_GAMES; i++) {
+		struct highscore_table_t *t = &tables[i];
+		int rc = shadow_read(EEPROM_HS_OFFSET + i * EEPROM_PAGE_SIZE, t, sizeof(*t));
+		if (rc < 0 || t->magic != HIGHSCORE_MAGIC || t->game != i ||
+			t->n > HIGHSCORE_TOP_N || t->crc != highscore_crc(t)) {
+			printk("[%s] no table for game %u; resetting.\n", __func__, i);
+			highscore_reset(i);
+		}
+	}
+}
+
+void highscore_reset_all()
+{
+	for (unsigned i = 0; i < N_GAMES; i++)
+		highscore_reset(i);
+}
+
+int highscore_add(uint8_t game, unsigned score)
+{
+	if (game >= N_GAMES)
+		return -1;
+	struct highscore_table_t *t = &tables[game];
+	++t->play_count;
+
+	// insertion into the sorted table; ties rank below the older score
+	int rank = -1;
+	score = MIN(score, UINT16_MAX);
+	if (score > 0) {
+		unsigned i = MIN(t->n, HIGHSCORE_TOP_N - 1);
+		if (t->n < HIGHSCORE_TOP_N || score > t->score[i]) {
+			t->n = MIN(t->n + 1, HIGHSCORE_TOP_N);
+			for (; i > 0 && t->score[i - 1] < score; i--)
+				t->score[i] = t->score[i - 1];
+			t->score[i] = score;
+			rank = i;
+		}
+	}
+	highscore_save(game);
+
+	printk("[%s] game=%u score=%u rank=%d plays=%u\n", __func__, game, score,
+		rank, t->play_count);
+	return rank;
+}
+
+const struct highscore_table_t *highscore_get(uint8_t game)
+{
+	return (game < N_GAMES) ? &tables[game] : NULL;
+}
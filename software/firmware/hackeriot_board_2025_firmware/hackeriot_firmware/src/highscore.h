@@ -0,0 +1,40 @@
+/*
+ * Copyright (c) 2025 Benny Meisels <benny.meisels@gmail.com>
+ *                    Rani Hod <rani.hod@gmail.com>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef __HIGHSCORE_H__
+#define __HIGHSCORE_H__
+
+#include <zephyr/kernel.h>
+
+#include "persist.h"
+
+// A table of the best scores, highest first, and a play counter per game.
+// Each table is one EEPROM page in the shadow (see shadow.h) and is kept
+// in RAM, so lookups and updates cost no I2C; a table is written back only
+// when it changes.
+#define HIGHSCORE_TOP_N		10
+#define HIGHSCORE_MAGIC		0x5348	/* 'HS' */
+
+struct highscore_table_t {
+	uint16_t	magic;
+	uint8_t		game;
+	uint8_t		n;						// scores used
+	uint32_t	play_count;
+	uint16_t	score[HIGHSCORE_TOP_N];	// highest first
+	uint16_t	crc;					// CRC-16/CCITT of all the above
+};
+
+void highscore_init();
+void highscore_reset_all();
+
+// counts a play; returns the rank of score in its table (0 for the best),
+// or -1 if it did not make the table
+int highscore_add(uint8_t game, unsigned score);
+
+const struct highscore_table_t *highscore_get(uint8_t game);
+
+#endif // __HIGHSCORE_H__
@@ -5,21 +5,21 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
-#include <zephyr/input/input.h>
 #include <zephyr/sys/printk.h>
 
+#include "gesture.h"
 #include "kc.h"
 #include "led.h"
 
 struct konami_code_t konami_code;
 
-// LED breath thread globals
-static K_THREAD_STACK_DEFINE(breath_thread_stack, 500);
-static struct k_thread breath_thread;
-static k_tid_t breath_tid = 0;
+// LED breath, one brightness step per run of a work item: down in 15
+// steps, then up again. A thread of its own would cost 500 bytes of stack.
+static void breath_work_func(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(breath_work, breath_work_func);
+static uint8_t breath_step;
 
-// LED breath thread entry point
-static void breath_thread_func(void*, void*, void*)
+static void breath_work_func(struct k_work *work)
 {
 	const struct device *const led = DEVICE_DT_GET(LED_NODE);
 	if ( ! device_is_ready(led)) {
@@ -29,74 +29,41 @@ static void breath_thread_func(void*, void*, void*)
 	// n=15; [int(.48+(1000*2/math.pi)*(math.asin((i+1)/n)-math.asin(i/n))) for i in range(n)][::-1]
 	static const uint8_t delta[] = {
 		234, 99, 77, 66, 59, 55, 52, 49, 47, 46, 44, 44, 43, 43, 42};
-	while(1) {
-		for (int i = 0; i < 15; i++) {
-			led_set_brightness(led, 0, (15-i)*100/15);
-			k_usleep(delta[i]*400);
-		}
-		for (int i = 0; i < 15; i++) {
-			led_set_brightness(led, 0, i*100/15);
-			k_usleep(delta[14-i]*400);
-		}
-	}
+	unsigned i = breath_step % 15;
+	bool up = breath_step >= 15;
+	led_set_brightness(led, 0, (up ? i : 15-i)*100/15);
+	breath_step = (breath_step + 1) % 30;
+	k_work_schedule(&breath_work, K_USEC((up ? delta[14-i] : delta[i])*400));
 }
 
-static void kc_button_cb(struct input_event *evt, void *userdata)
+static void kc_matched(void *userdata)
 {
 	struct konami_code_t * const kc = userdata;
 
-	if ( ! evt->value) return; // ignore button release
-
-	static const uint16_t konami_code[] = {
-		INPUT_BTN_DPAD_UP,
-		INPUT_BTN_DPAD_UP,
-		INPUT_BTN_DPAD_DOWN,
-		INPUT_BTN_DPAD_DOWN,
-		INPUT_BTN_DPAD_LEFT,
-		INPUT_BTN_DPAD_RIGHT,
-		INPUT_BTN_DPAD_LEFT,
-		INPUT_BTN_DPAD_RIGHT,
-		INPUT_BTN_B,
-		INPUT_BTN_A
-	};
-
-	unsigned st = kc->state;
-	uint16_t code = evt->code;
-	if (code == konami_code[st]) {
-		++st;
-		if (st == ARRAY_SIZE(konami_code)) {
-			printk("Konami code entered\n");
-			st = 0;
-			kc->active = ! kc->active;
+	printk("Konami code entered\n");
+	kc->active = ! kc->active;
 
-			if (kc->active) {
-				// start/resume LED breath thread
-				if ( ! breath_tid)
-					breath_tid = k_thread_create(
-						&breath_thread,                                  // new_thread
-						breath_thread_stack,                             // stack
-						K_THREAD_STACK_SIZEOF(breath_thread_stack),      // stack_size
-						&breath_thread_func,                             // entry
-						NULL,                                            // p1
-						NULL,                                            // p2
-						NULL,                                            // p3
-						5,                                               // prio
-						0,                                               // options
-						K_NO_WAIT);                                      // delay
-				else
-					k_thread_resume(breath_tid);
-			} else {
-				// suspend thread
-				k_thread_suspend(breath_tid);
-			}
-		}
-	} else if (code == konami_code[0]) {
-		if (st != 2) st = 1;	// 2 stays 2
-	} else st = 0;
-	kc->state = st;
-
-	if (st > 2)
-		printk("state=%u active=%c\n", st, "NY"[kc->active]);
+	// start/resume or stop LED breathing
+	if (kc->active)
+		k_work_schedule(&breath_work, K_NO_WAIT);
+	else
+		k_work_cancel_delayable(&breath_work);
 }
 
-INPUT_CALLBACK_DEFINE(NULL, kc_button_cb, &konami_code);
+void kc_init()
+{
+	static const uint8_t konami_code_keys[] = {
+		BUTTON_UP,
+		BUTTON_UP,
+		BUTTON_DOWN,
+		BUTTON_DOWN,
+		BUTTON_LEFT,
+		BUTTON_RIGHT,
+		BUTTON_LEFT,
+		BUTTON_RIGHT,
+		BUTTON_B,
+		BUTTON_A
+	};
+	gesture_add_sequence(konami_code_keys, ARRAY_SIZE(konami_code_keys),
+		kc_matched, &konami_code);
+}
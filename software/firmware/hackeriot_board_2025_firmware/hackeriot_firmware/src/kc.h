@@ -11,8 +11,9 @@
 
 
 struct konami_code_t {
-	unsigned int state	: 4;	// number of matches so far
 	unsigned int active	: 1;
 };
 
+void kc_init();
+
 #endif // __KC_H__
@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) 2025 Benny Meisels <benny.meisels@gmail.com>
+ *                    Rani Hod <rani.hod@gmail.com>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/drivers/gpio.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/printk.h>
+
+#include "latency.h"
+
+#define BTN_NODE DT_COMPAT_GET_ANY_STATUS_OKAY(gpio_keys)
+
+enum latency_point {
+	POINT_EDGE = 0,
+	POINT_INPUT,
+	POINT_READ,
+	POINT_PUBLISH,
+	POINT_VISIBLE,
+	POINT_END /* keep last */
+};
+
+// a stage spans from one point to the next, the last one is the total
+#define STAGE_TOTAL	(POINT_END - 1)
+#define STAGE_END	POINT_END
+
+static const char * const stage_names[STAGE_END] = {
+	"edge->input",
+	"input->read",
+	"read->publish",
+	"publish->visible",
+	"edge->visible",
+};
+
+// The trace moves IDLE -> INPUT -> READ -> PUBLISHED -> IDLE, each step
+// taken by whichever thread reaches that point. BUSY guards the fields
+// while one of them writes.
+enum latency_state {
+	STATE_IDLE = 0,
+	STATE_BUSY,
+	STATE_INPUT,
+	STATE_READ,
+	STATE_PUBLISHED,
+};
+
+static atomic_t trace_state;
+static uint32_t trace_cycles[POINT_END];
+static uint32_t trace_seq; // of the published frame
+
+static uint16_t samples[STAGE_END][LATENCY_SAMPLES]; // us
+static uint32_t n_traces;
+static uint32_t n_dropped;
+
+// the report sorts and prints on the system workqueue, the screen thread
+// has no stack to spare for it
+static void latency_report(struct k_work *work)
+{
+	latency_print();
+}
+static K_WORK_DEFINE(report_work, latency_report);
+
+// first button pin edge since the last input event
+static atomic_t edge_valid;
+static uint32_t edge_cycles;
+
+#define BUTTON_SPEC(node) GPIO_DT_SPEC_GET(node, gpios),
+static const struct gpio_dt_spec buttons[] = {
+	DT_FOREACH_CHILD(BTN_NODE, BUTTON_SPEC)
+};
+static struct gpio_callback edge_cb[ARRAY_SIZE(buttons)];
+
+static void latency_edge_cb(const struct device *port, struct gpio_callback *cb,
+	gpio_port_pins_t pins)
+{
+	uint32_t now = k_cycle_get_32();
+	if (atomic_cas(&edge_valid, 0, 1))
+		edge_cycles = now;
+}
+
+// gpio-keys keeps its own pin interrupts; this callback just listens too
+void latency_init()
+{
+	for (unsigned i = 0; i < ARRAY_SIZE(buttons); i++) {
+		gpio_init_callback(&edge_cb[i], latency_edge_cb, BIT(buttons[i].pin));
+		int rc = gpio_add_callback_dt(&buttons[i], &edge_cb[i]);
+		if (rc < 0)
+			printk("[%s] no edge callback for button %u; code=%d.\n", __func__, i, rc);
+	}
+	printk("[%s] tracing button-to-photon latency\n", __func__);
+}
+
+static uint32_t since(uint32_t cycles)
+{
+	return k_cyc_to_us_floor32(k_cycle_get_32() - cycles);
+}
+
+void latency_input(uint32_t cycles, bool pressed)
+{
+	uint32_t edge = cycles;
+	if (atomic_get(&edge_valid)) {
+		edge = edge_cycles;
+		atomic_clear(&edge_valid);
+		if (k_cyc_to_us_floor32(cycles - edge) > LATENCY_TIMEOUT_MS * 1000U)
+			edge = cycles; // not this event's edge
+	}
+	if ( ! pressed)
+		return;
+
+	// start a trace, unless one is in flight; a stuck one is dropped
+	atomic_val_t state = atomic_get(&trace_state);
+	if (state != STATE_IDLE &&
+		since(trace_cycles[POINT_INPUT]) < LATENCY_TIMEOUT_MS * 1000U)
+		return;
+	if (state == STATE_BUSY || ! atomic_cas(&trace_state, state, STATE_BUSY))
+		return;
+	if (state != STATE_IDLE)
+		++n_dropped;
+	trace_cycles[POINT_EDGE] = edge;
+	trace_cycles[POINT_INPUT] = cycles;
+	atomic_set(&trace_state, STATE_INPUT);
+}
+
+void latency_read(const struct buttons_event_t *evt)
+{
+	if ( ! atomic_cas(&trace_state, STATE_INPUT, STATE_BUSY))
+		return;
+	if (evt->pressed && evt->cycles == trace_cycles[POINT_INPUT]) {
+		trace_cycles[POINT_READ] = k_cycle_get_32();
+		atomic_set(&trace_state, STATE_READ);
+	} else
+		atomic_set(&trace_state, STATE_INPUT); // some other event
+}
+
+void latency_publish(uint32_t seq)
+{
+	if ( ! atomic_cas(&trace_state, STATE_READ, STATE_BUSY))
+		return;
+	trace_cycles[POINT_PUBLISH] = k_cycle_get_32();
+	trace_seq = seq;
+	atomic_set(&trace_state, STATE_PUBLISHED);
+}
+
+void latency_visible(uint32_t seq)
+{
+	if ( ! atomic_cas(&trace_state, STATE_PUBLISHED, STATE_BUSY))
+		return;
+	if ((int32_t)(seq - trace_seq) < 0) {
+		atomic_set(&trace_state, STATE_PUBLISHED); // an older frame
+		return;
+	}
+	trace_cycles[POINT_VISIBLE] = k_cycle_get_32();
+
+	unsigned slot = n_traces++ % LATENCY_SAMPLES;
+	for (unsigned s = 0; s < STAGE_END; s++) {
+		uint32_t from = trace_cycles[s == STAGE_TOTAL ? POINT_EDGE : s];
+		uint32_t to = trace_cycles[s == STAGE_TOTAL ? POINT_VISIBLE : s + 1];
+		samples[s][slot] = MIN(k_cyc_to_us_floor32(to - from), UINT16_MAX);
+	}
+	atomic_set(&trace_state, STATE_IDLE);
+
+	if (n_traces % LATENCY_REPORT_EVERY == 0)
+		k_work_submit(&report_work);
+}
+
+// p50/p90/p99/max of the last LATENCY_SAMPLES presses, in microseconds;
+// a press traced meanwhile may replace one of the samples being sorted
+void latency_print()
+{
+	unsigned n = MIN(n_traces, LATENCY_SAMPLES);
+	printk("latency: %u presses, %u dropped, last %u:\n", n_traces, n_dropped, n);
+	if ( ! n)
+		return;
+
+	for (unsigned s = 0; s < STAGE_END; s++) {
+		uint16_t sorted[LATENCY_SAMPLES];
+		for (unsigned i = 0; i < n; i++) {
+			// insertion sort
+			unsigned j = i;
+			for (; j > 0 && sorted[j - 1] > samples[s][i]; j--)
+				sorted[j] = sorted[j - 1];
+			sorted[j] = samples[s][i];
+		}
+		printk("latency %-16s p50=%u p90=%u p99=%u max=%u us\n", stage_names[s],
+			sorted[n * 50 / 100], sorted[n * 90 / 100], sorted[n * 99 / 100],
+			sorted[n - 1]);
+	}
+}
@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) 2025 Benny Meisels <benny.meisels@gmail.com>
+ *                    Rani Hod <rani.hod@gmail.com>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef __LATENCY_H__
+#define __LATENCY_H__
+
+#include <zephyr/kernel.h>
+
+#include "buttons.h"
+
+// Button-to-photon latency tracing, built with -DLATENCY_TRACE=ON.
+// One button press at a time is followed through the stages
+//   edge      GPIO interrupt on the button pin
+//   input     gpio-keys input event, after debouncing
+//   read      the event leaves the buttons ring
+//   publish   the next frame is published to the screen thread
+//   visible   the screen thread finishes writing that frame (or a newer
+//             one) to the HT16K33 over I2C
+// and percentiles of each stage are printed every LATENCY_REPORT_EVERY
+// presses. The screen thread only records; the system workqueue prints.
+
+#define LATENCY_SAMPLES         32  // per stage, for percentiles
+#define LATENCY_REPORT_EVERY    16  // presses
+#define LATENCY_TIMEOUT_MS      500 // a press without a visible change
+
+#ifdef LATENCY_TRACE
+void latency_init();
+void latency_input(uint32_t cycles, bool pressed);
+void latency_read(const struct buttons_event_t *evt);
+void latency_publish(uint32_t seq);
+void latency_visible(uint32_t seq);
+void latency_print();
+#else
+static inline void latency_init() {}
+static inline void latency_input(uint32_t cycles, bool pressed) {}
+static inline void latency_read(const struct buttons_event_t *evt) {}
+static inline void latency_publish(uint32_t seq) {}
+static inline void latency_visible(uint32_t seq) {}
+static inline void latency_print() {}
+#endif
+
+#endif // __LATENCY_H__
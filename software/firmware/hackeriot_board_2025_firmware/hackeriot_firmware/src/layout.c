@@ -0,0 +1,257 @@
+/*
+ * Copyright (c) 2025 Benny Meisels <benny.meisels@gmail.com>
+ *                    Rani Hod <rani.hod@gmail.com>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/sys/printk.h>
+
+#include "layout.h"
+
+// bidi character types, a subset of UAX #9
+enum bidi_type {
+	BIDI_L,		// strong left-to-right
+	BIDI_R,		// strong right-to-left
+	BIDI_EN,	// European number
+	BIDI_ES,	// number separator (+ -)
+	BIDI_ET,	// number terminator (# $ % ...)
+	BIDI_CS,	// common number separator (, . / :)
+	BIDI_NSM,	// non-spacing mark
+	BIDI_ON,	// neutral (whitespace and other)
+};
+
+static uint8_t types[LAYOUT_MAX];
+static uint8_t levels[LAYOUT_MAX];
+
+// decode one UTF-8 sequence and advance; malformed input yields U+FFFD
+static uint32_t utf8_next(const char **text)
+{
+	const uint8_t *p = (const uint8_t *)*text;
+	uint32_t cp = *p++;
+	if (cp >= 0x80) {
+		unsigned extra = (cp >= 0xf0) ? 3 : (cp >= 0xe0) ? 2 : (cp >= 0xc0) ? 1 : 0;
+		if ( ! extra || cp >= 0xf8) {
+			cp = 0xfffd;
+		} else {
+			cp &= 0x3f >> extra;
+			while (extra--) {
+				if ((*p & 0xc0) != 0x80) {
+					cp = 0xfffd;
+					break;
+				}
+				cp = (cp << 6) | (*p++ & 0x3f);
+			}
+		}
+	}
+	*text = (const char *)p;
+	return cp;
+}
+
+bool layout_is_mark(uint16_t cp)
+{
+	return (cp >= 0x300 && cp <= 0x36f) ||
+		(cp >= 0x591 && cp <= 0x5c7 &&
+		 cp != 0x5be && cp != 0x5c0 && cp != 0x5c3 && cp != 0x5c6);
+}
+
+static enum bidi_type bidi_type(uint16_t cp)
+{
+	if (layout_is_mark(cp))
+		return BIDI_NSM;
+	if (cp >= 0x590 && cp <= 0x5ff)
+		return BIDI_R;
+	if ((cp >= '0' && cp <= '9') || cp == 0xb2 || cp == 0xb3 || cp == 0xb9)
+		return BIDI_EN;
+	if (cp == '+' || cp == '-')
+		return BIDI_ES;
+	if (cp == ',' || cp == '.' || cp == '/' || cp == ':' || cp == 0xa0)
+		return BIDI_CS;
+	if (cp == '#' || cp == '$' || cp == '%' || (cp >= 0xa2 && cp <= 0xa5) ||
+		cp == 0xb0 || cp == 0xb1 || cp == 0x20aa)
+		return BIDI_ET;
+	if ((cp >= 'A' && cp <= 'Z') || (cp >= 'a' && cp <= 'z') ||
+		cp == 0xaa || cp == 0xb5 || cp == 0xba ||
+		(cp >= 0xc0 && cp <= 0x24f && cp != 0xd7 && cp != 0xf7))
+		return BIDI_L;
+	return BIDI_ON;
+}
+
+static uint16_t bidi_mirror(uint16_t cp)
+{
+	static const char pairs[] = "()<>[]{}";
+	for (unsigned i = 0; pairs[i]; i++)
+		if (cp == (uint8_t)pairs[i])
+			return pairs[i ^ 1];
+	if (cp == 0xab) return 0xbb;
+	if (cp == 0xbb) return 0xab;
+	return cp;
+}
+
+static void reverse(uint16_t *glyphs, unsigned from, unsigned to)
+{
+	for (unsigned i = from, j = to - 1; i < j; i++, j--) {
+		uint16_t g = glyphs[i];
+		glyphs[i] = glyphs[j];
+		glyphs[j] = g;
+		uint8_t l = levels[i];
+		levels[i] = levels[j];
+		levels[j] = l;
+	}
+}
+
+unsigned layout_text(const char *text, bool rtl, uint16_t glyphs[LAYOUT_MAX])
+{
+	// decode and classify
+	unsigned n = 0;
+	while (*text) {
+		uint32_t cp = utf8_next(&text);
+		if (n == LAYOUT_MAX) {
+			printk("[%s] text truncated at %u code points\n", __func__, n);
+			break;
+		}
+		glyphs[n] = (cp > 0xffff) ? 0xfffd : cp;
+		types[n] = bidi_type(glyphs[n]);
+		n++;
+	}
+
+	// paragraph direction (P2, P3)
+	for (unsigned i = 0; i < n; i++) {
+		if (types[i] == BIDI_L || types[i] == BIDI_R) {
+			rtl = (types[i] == BIDI_R);
+			break;
+		}
+	}
+	const enum bidi_type base = rtl ? BIDI_R : BIDI_L;
+
+	// weak types: marks take the previous type (W1), a single separator
+	// between numbers joins them (W4), terminators next to numbers become
+	// numbers (W5), other separators are neutral (W6), and numbers after
+	// a left-to-right letter are left-to-right (W7)
+	enum bidi_type prev = base, strong = base;
+	for (unsigned i = 0; i < n; i++) {
+		if (types[i] == BIDI_NSM)
+			types[i] = prev;
+		prev = types[i];
+	}
+	for (unsigned i = 1; i + 1 < n; i++) {
+		if (types[i - 1] == BIDI_EN && types[i + 1] == BIDI_EN &&
+			(types[i] == BIDI_ES || types[i] == BIDI_CS))
+			types[i] = BIDI_EN;
+	}
+	for (unsigned i = 0; i < n; i++) {
+		if (types[i] != BIDI_ET)
+			continue;
+		unsigned j = i;
+		while (j < n && types[j] == BIDI_ET) j++;
+		bool number = (i && types[i - 1] == BIDI_EN) || (j < n && types[j] == BIDI_EN);
+		for (; i < j; i++)
+			types[i] = number ? BIDI_EN : BIDI_ON;
+		i--;
+	}
+	for (unsigned i = 0; i < n; i++) {
+		if (types[i] == BIDI_ES || types[i] == BIDI_CS)
+			types[i] = BIDI_ON;
+		else if (types[i] == BIDI_L || types[i] == BIDI_R)
+			strong = types[i];
+		else if (types[i] == BIDI_EN && strong == BIDI_L)
+			types[i] = BIDI_L;
+	}
+
+	// bracket pairs enclosing a strong type take the paragraph direction
+	// if it matches, else the enclosed direction if it also precedes the
+	// pair (N0); numbers count as right-to-left
+	for (unsigned o = 0; o < n; o++) {
+		if (glyphs[o] != '(' && glyphs[o] != '[' && glyphs[o] != '{')
+			continue; // not an opening bracket
+		uint16_t close = bidi_mirror(glyphs[o]);
+		unsigned c = o + 1, depth = 0;
+		for (; c < n; c++) {
+			if (glyphs[c] == glyphs[o]) depth++;
+			else if (glyphs[c] == close && ! depth--) break;
+		}
+		if (c == n)
+			continue; // unmatched
+		bool same = false, opposite = false;
+		for (unsigned i = o + 1; i < c; i++) {
+			enum bidi_type t = (types[i] == BIDI_EN) ? BIDI_R : types[i];
+			same |= (t == base);
+			opposite |= (t == BIDI_L || t == BIDI_R) && t != base;
+		}
+		enum bidi_type resolved = base;
+		if ( ! same) {
+			if ( ! opposite)
+				continue;
+			enum bidi_type before = base;
+			for (unsigned i = o; i-- > 0; ) {
+				if (types[i] == BIDI_L || types[i] == BIDI_R || types[i] == BIDI_EN) {
+					before = (types[i] == BIDI_EN) ? BIDI_R : types[i];
+					break;
+				}
+			}
+			resolved = before;
+		}
+		types[o] = types[c] = resolved;
+	}
+
+	// neutrals between two like directions take it, others take the
+	// paragraph direction (N1, N2); numbers count as right-to-left
+	for (unsigned i = 0; i < n; i++) {
+		if (types[i] != BIDI_ON)
+			continue;
+		unsigned j = i;
+		while (j < n && types[j] == BIDI_ON) j++;
+		enum bidi_type before = i ? types[i - 1] : base;
+		enum bidi_type after = (j < n) ? types[j] : base;
+		if (before == BIDI_EN) before = BIDI_R;
+		if (after == BIDI_EN) after = BIDI_R;
+		enum bidi_type resolved = (before == after) ? before : base;
+		for (; i < j; i++)
+			types[i] = resolved;
+		i--;
+	}
+
+	// implicit levels (I1, I2)
+	uint8_t max_level = 0;
+	for (unsigned i = 0; i < n; i++) {
+		if (rtl)
+			levels[i] = (types[i] == BIDI_R) ? 1 : 2;
+		else
+			levels[i] = (types[i] == BIDI_L) ? 0 : (types[i] == BIDI_R) ? 1 : 2;
+		max_level = MAX(max_level, levels[i]);
+	}
+
+	// mirror brackets in right-to-left runs (L4)
+	for (unsigned i = 0; i < n; i++) {
+		if (levels[i] & 1)
+			glyphs[i] = bidi_mirror(glyphs[i]);
+	}
+
+	// reverse runs from the highest level down to the lowest odd one (L2)
+	for (uint8_t level = max_level; level >= 1; level--) {
+		for (unsigned i = 0; i < n; i++) {
+			if (levels[i] < level)
+				continue;
+			unsigned j = i;
+			while (j < n && levels[j] >= level) j++;
+			reverse(glyphs, i, j);
+			i = j;
+		}
+	}
+
+	// keep combining marks after their base (L3)
+	for (unsigned i = 0; i < n; i++) {
+		if ( ! layout_is_mark(glyphs[i]))
+			continue;
+		unsigned j = i;
+		while (j < n && layout_is_mark(glyphs[j])) j++;
+		if (j < n && (levels[j] & 1)) {
+			uint16_t g = glyphs[j];
+			memmove(&glyphs[i + 1], &glyphs[i], (j - i) * sizeof(glyphs[0]));
+			glyphs[i] = g;
+		}
+		i = j;
+	}
+
+	return n;
+}
@@ -0,0 +1,26 @@
+/*
+ * Copyright (c) 2025 Benny Meisels <benny.meisels@gmail.com>
+ *                    Rani Hod <rani.hod@gmail.com>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef __LAYOUT_H__
+#define __LAYOUT_H__
+
+#include <zephyr/kernel.h>
+
+#define LAYOUT_MAX  64  // code points per laid out text
+
+// Decodes UTF-8 text once and reorders it for display with a simplified
+// Unicode bidi algorithm (Hebrew, Latin, numbers, neutrals and mirrored
+// brackets). The paragraph direction is taken from the first strong
+// character, or from rtl if there is none. Fills glyphs with code points
+// in visual order, left to right, each combining mark right after its
+// base. Returns the number of code points.
+unsigned layout_text(const char *text, bool rtl, uint16_t glyphs[LAYOUT_MAX]);
+
+// true for combining marks, which are drawn over the preceding glyph
+bool layout_is_mark(uint16_t cp);
+
+#endif // __LAYOUT_H__
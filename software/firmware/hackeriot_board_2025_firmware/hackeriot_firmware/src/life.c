@@ -0,0 +1,262 @@
+/*
+ * Copyright (c) 2025 Benny Meisels <benny.meisels@gmail.com>
+ *                    Rani Hod <rani.hod@gmail.com>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <zephyr/sys/printk.h>
+
+#include "bitboard.h"
+#include "game.h"
+#include "life.h"
+#include "replay.h"
+#include "screen.h"
+
+#define LIFE_WIDTH	(8 * LIFE_TILES_X)	// cells
+#define LIFE_HEIGHT	(8 * LIFE_TILES_Y)
+
+// tile (tx, ty) is life_world[ty][tx]; like pixels in a tile, tx grows
+// to the left and ty upwards
+static uint64_t life_world[LIFE_TILES_Y][LIFE_TILES_X];
+
+static const char * const life_rules[] = {
+	"B3/S23",			// Conway's Life
+	"B36/S23",			// HighLife
+	"B3678/S34678",		// Day & Night
+	"B2/S",				// Seeds
+	"B1357/S1357",		// Replicator
+};
+
+struct life_data_t {
+	struct life_rule_t rule;
+	uint32_t generation;
+	uint16_t view_x, view_y;	// world cell at the screen's bottom right
+	uint8_t rule_index;			// into life_rules
+	bool quit;
+};
+
+int life_parse_rule(const char *text, struct life_rule_t *rule)
+{
+	uint16_t *counts = NULL;
+	*rule = (struct life_rule_t){0};
+	for (const char *c = text; *c; c++) {
+		if (*c == 'B' || *c == 'b')
+			counts = &rule->born;
+		else if (*c == 'S' || *c == 's')
+			counts = &rule->survive;
+		else if (*c >= '0' && *c <= '8' && counts)
+			*counts |= BIT(*c - '0');
+		else if (*c != '/')
+			return -EINVAL;
+	}
+	return counts ? 0 : -EINVAL;
+}
+
+// each cell takes the value of its neighbour one pixel away, the edge
+// coming from the next tile that way
+static inline uint64_t from_below(uint64_t x, uint64_t below)
+{
+	return (x << 8) | (below >> 56);
+}
+static inline uint64_t from_above(uint64_t x, uint64_t above)
+{
+	return (x >> 8) | (above << 56);
+}
+static inline uint64_t from_right(uint64_t x, uint64_t right)
+{
+	return ((x & ~BB_COLUMN_7) << 1) | ((right & BB_COLUMN_7) >> 7);
+}
+static inline uint64_t from_left(uint64_t x, uint64_t left)
+{
+	return ((x & ~BB_COLUMN_0) >> 1) | ((left & BB_COLUMN_0) << 7);
+}
+
+// bit-sliced full adder: 64 independent one-bit sums
+static inline void full_add(uint64_t a, uint64_t b, uint64_t c,
+	uint64_t *sum, uint64_t *carry)
+{
+	uint64_t t = a ^ b;
+	*sum = t ^ c;
+	*carry = (a & b) | (t & c);
+}
+
+// next generation of tile tx in row, given the old rows below and above
+static uint64_t life_tile(const uint64_t *below, const uint64_t *row,
+	const uint64_t *above, unsigned tx, const struct life_rule_t *rule)
+{
+	unsigned r = (tx + LIFE_TILES_X - 1) % LIFE_TILES_X;
+	unsigned l = (tx + 1) % LIFE_TILES_X;
+
+	// the 8 neighbours of every cell, as 8 boards
+	uint64_t c = row[tx];
+	uint64_t b = from_below(c, below[tx]);
+	uint64_t a = from_above(c, above[tx]);
+	uint64_t n0 = from_right(c, row[r]);
+	uint64_t n1 = from_left(c, row[l]);
+	uint64_t n2 = from_right(b, from_below(row[r], below[r]));
+	uint64_t n3 = from_left(b, from_below(row[l], below[l]));
+	uint64_t n4 = from_right(a, from_above(row[r], above[r]));
+	uint64_t n5 = from_left(a, from_above(row[l], above[l]));
+
+	// count them into 4 bit planes: ones + 2 twos + 4 fours + 8 eights
+	uint64_t s0, c0, s1, c1, ones, c2, t, c3;
+	full_add(n0, n1, n2, &s0, &c0);
+	full_add(n3, n4, n5, &s1, &c1);
+	full_add(s0, s1, a ^ b, &ones, &c2);
+	full_add(c0, c1, a & b, &t, &c3);
+	uint64_t twos = t ^ c2;
+	uint64_t fours = c3 ^ (t & c2);
+	uint64_t eights = c3 & t & c2;
+
+	// match the counts the rule names
+	uint64_t born = 0, survive = 0;
+	for (uint16_t counts = rule->born | rule->survive; counts; counts &= counts - 1) {
+		unsigned k = __builtin_ctz(counts);
+		uint64_t eq = ((k & 1) ? ones : ~ones) & ((k & 2) ? twos : ~twos) &
+			((k & 4) ? fours : ~fours) & ((k & 8) ? eights : ~eights);
+		if (rule->born & BIT(k))
+			born |= eq;
+		if (rule->survive & BIT(k))
+			survive |= eq;
+	}
+	return (born & ~c) | (survive & c);
+}
+
+// one generation in place; rows of old tiles are kept for the neighbours
+static void life_step(const struct life_rule_t *rule)
+{
+	static uint64_t first[LIFE_TILES_X];	// row 0, the one above the top row
+	static uint64_t rows[2][LIFE_TILES_X];
+	uint64_t *below = rows[0], *row = rows[1];
+
+	memcpy(first, life_world[0], sizeof(first));
+	memcpy(below, life_world[LIFE_TILES_Y - 1], sizeof(first));
+	for (unsigned ty = 0; ty < LIFE_TILES_Y; ty++) {
+		memcpy(row, life_world[ty], sizeof(first));
+		const uint64_t *above = (ty + 1 < LIFE_TILES_Y) ? life_world[ty + 1] : first;
+		for (unsigned tx = 0; tx < LIFE_TILES_X; tx++)
+			life_world[ty][tx] = life_tile(below, row, above, tx, rule);
+		uint64_t *swap = below;
+		below = row;
+		row = swap;
+	}
+}
+
+// about a quarter of the cells alive
+static void life_seed()
+{
+	for (unsigned ty = 0; ty < LIFE_TILES_Y; ty++)
+		for (unsigned tx = 0; tx < LIFE_TILES_X; tx++) {
+			uint64_t a = ((uint64_t)replay_rand32() << 32) | replay_rand32();
+			uint64_t b = ((uint64_t)replay_rand32() << 32) | replay_rand32();
+			life_world[ty][tx] = a & b;
+		}
+}
+
+static bool life_dead()
+{
+	uint64_t any = 0;
+	for (unsigned ty = 0; ty < LIFE_TILES_Y; ty++)
+		for (unsigned tx = 0; tx < LIFE_TILES_X; tx++)
+			any |= life_world[ty][tx];
+	return ! any;
+}
+
+// the 8x8 cells from (x, y) up and to the left, wrapping
+static uint64_t life_view(unsigned x, unsigned y)
+{
+	uint64_t view = 0;
+	unsigned tx = x / 8;
+	for (unsigned r = 0; r < 8; r++) {
+		unsigned wy = (y + r) % LIFE_HEIGHT;
+		const uint64_t *tiles = life_world[wy / 8];
+		unsigned shift = 8 * (wy % 8);
+		uint16_t bits = (uint8_t)(tiles[tx] >> shift) |
+			(uint16_t)(uint8_t)(tiles[(tx + 1) % LIFE_TILES_X] >> shift) << 8;
+		view |= (uint64_t)(uint8_t)(bits >> (x % 8)) << (8 * r);
+	}
+	return view;
+}
+
+static void life_set_rule(struct life_data_t *ld, unsigned index)
+{
+	ld->rule_index = index % ARRAY_SIZE(life_rules);
+	life_parse_rule(life_rules[ld->rule_index], &ld->rule);
+	ld->generation = 0;
+	life_seed();
+	printk("[%s] rule %s\n", __func__, life_rules[ld->rule_index]);
+}
+
+static void life_input(void *state, char btn)
+{
+	struct life_data_t *ld = state;
+	switch (btn) {
+		case 'U': ld->view_y = (ld->view_y + 1) % LIFE_HEIGHT; break;
+		case 'D': ld->view_y = (ld->view_y + LIFE_HEIGHT - 1) % LIFE_HEIGHT; break;
+		case 'L': ld->view_x = (ld->view_x + 1) % LIFE_WIDTH; break;
+		case 'R': ld->view_x = (ld->view_x + LIFE_WIDTH - 1) % LIFE_WIDTH; break;
+		case 'A': life_set_rule(ld, ld->rule_index + 1); break;
+		case 'B': ld->quit = true; break;
+	}
+}
+
+static bool life_update(void *state)
+{
+	struct life_data_t *ld = state;
+	if (ld->quit)
+		return false;
+	life_step(&ld->rule);
+	++ld->generation;
+	if (life_dead()) {
+		printk("[%s] died out after %u generations\n", __func__, ld->generation);
+		life_set_rule(ld, ld->rule_index);
+	}
+	return true;
+}
+
+static void life_render(const void *state)
+{
+	const struct life_data_t *ld = state;
+	screen_set(life_view(ld->view_x, ld->view_y));
+}
+
+static uint32_t life_tick_ms(const void *state)
+{
+	return LIFE_TICK_MS;
+}
+
+static const struct game_t life = {
+	.name		= "life",
+	.buttons	= "U+D+L+R+AB",
+	.input		= life_input,
+	.update		= life_update,
+	.render		= life_render,
+	.tick_ms	= life_tick_ms,
+};
+
+void play_life()
+{
+	struct life_data_t ld = {0};
+	life_set_rule(&ld, 0);
+	game_run(&life, &ld, GAME_REALTIME);
+	screen_set(0);
+	printk("[%s] %u generations\n", __func__, ld.generation);
+}
+
+void life_benchmark(unsigned generations)
+{
+	struct life_rule_t rule;
+	life_parse_rule(life_rules[0], &rule);
+	life_seed();
+	uint32_t start = k_uptime_get_32();
+	for (unsigned i = 0; i < generations; i++)
+		life_step(&rule);
+	uint32_t ms = MAX(k_uptime_get_32() - start, 1);
+	printk("[%s] %ux%u cells, %u generations in %u ms, %u gen/s, %u cells/ms\n",
+		__func__, LIFE_WIDTH, LIFE_HEIGHT, generations, ms,
+		(uint32_t)(1000ULL * generations / ms),
+		(uint32_t)((uint64_t)LIFE_WIDTH * LIFE_HEIGHT * generations / ms));
+}
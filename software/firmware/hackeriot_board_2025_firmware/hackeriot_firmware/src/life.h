@@ -0,0 +1,40 @@
+/*
+ * Copyright (c) 2025 Benny Meisels <benny.meisels@gmail.com>
+ *                    Rani Hod <rani.hod@gmail.com>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef __LIFE_H__
+#define __LIFE_H__
+
+#include <zephyr/kernel.h>
+
+// Cellular automata on a torus of LIFE_TILES_X by LIFE_TILES_Y bitboards,
+// wrapping like the snake's board; a single tile wraps exactly like
+// bb_wrap_*(). A generation counts all 64 neighbourhoods of a tile at
+// once with a bit-sliced adder over its 8 shifted copies, then applies
+// the rule to the count bits. The world is updated in place, keeping
+// only three rows of old tiles, so 32x32 cells take 224 bytes of the
+// 8 KiB of RAM. The screen is a viewport into the world, moved with the
+// D-pad; A picks the next rule and reseeds, B leaves.
+
+#define LIFE_TILES_X	4
+#define LIFE_TILES_Y	4
+#define LIFE_TICK_MS	150		// per generation
+
+// bit n of born/survive: the rule for n live neighbours
+struct life_rule_t {
+	uint16_t born;
+	uint16_t survive;
+};
+
+// parses "B3/S23" style rules; -EINVAL if malformed
+int life_parse_rule(const char *text, struct life_rule_t *rule);
+
+void play_life();
+
+// generations at full speed on a random world; prints generations per second
+void life_benchmark(unsigned generations);
+
+#endif // __LIFE_H__
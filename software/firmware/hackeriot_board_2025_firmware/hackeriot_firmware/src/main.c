@@ -9,35 +9,60 @@
 #include <zephyr/devicetree.h>
 #include <zephyr/sys/printk.h>
 
+#include "blocks.h"
 #include "buttons.h"
+#include "fontpack.h"
+#include "highscore.h"
+#include "kc.h"
+#include "latency.h"
 #include "led.h"
+#include "life.h"
 #include "persist.h"
-//#include "pong.h"
+#include "pong.h"
+#include "replay.h"
 #include "screen.h"
+#include "shadow.h"
 #include "simon.h"
 #include "snake.h"
 
 #define LED_NODE DT_COMPAT_GET_ANY_STATUS_OKAY(holtek_ht16k33)
 #define BTN_NODE DT_COMPAT_GET_ANY_STATUS_OKAY(gpio_keys)
+#if DT_HAS_COMPAT_STATUS_OKAY(atmel_at24)
 #define EEP_NODE DT_COMPAT_GET_ANY_STATUS_OKAY(atmel_at24)
+#else
+#define EEP_NODE DT_COMPAT_GET_ANY_STATUS_OKAY(zephyr_sim_eeprom) // native_sim
+#endif
 
 enum main_menu {
 	MENU_SNAKE,
 	MENU_SIMON,
 	MENU_PONG,
+	MENU_BLOCKS,
+	MENU_LIFE,		// not a game: no score or replays
 	MENU_SETTINGS,
 	MENU_END		// keep last
 };
+#define MENU_ATTRACT	MENU_END	// after idling in the menu, not an entry
+#define MENU_IDLE_LOOPS	5			// scrolls of an entry before that
+
+// by enum main_menu; also the game number for replays
+static unsigned (* const games[N_GAMES])() = {
+	[MENU_SNAKE]	= play_snake,
+	[MENU_SIMON]	= play_simon,
+	[MENU_PONG]		= play_pong,
+	[MENU_BLOCKS]	= play_blocks,
+};
 
 void boot_animation()
 {
 	printk("boot animation started\n");
 
-	const char *msg[] = {"Hackeriot 2025", "האקריות 5202"};
+	const char *msg[] = {"Hackeriot 2025", "האקריות 2025"};
 	bool skip = screen_scroll_once(msg[settings.lang], LANG_DIR, PIXEL_DELAY, NULL);
 	if ( ! skip) k_msleep(200);
 
 	printk("boot animation %sed\n", skip ? "skipp" : "finish");
+	screen_print_stats();
 }
 
 uint8_t do_menu()
@@ -46,13 +71,17 @@ uint8_t do_menu()
 		"1.Snake",
 		"2.Simon",
 		"3.Pong",
-		"4.Settings",
+		"4.Blocks",
+		"5.Life",
+		"6.Settings",
 	};
 	static const char * const hmenu_options[] = { 
 		"1.סנייק",
 		"2.סיימון",
 		"3.פונג",
-		"4.אפשרויות",
+		"4.בלוקים",
+		"5.חיים",
+		"6.אפשרויות",
 	};
 	uint8_t menu_pos = 0;
 	const char *msg;
@@ -64,10 +93,18 @@ uint8_t do_menu()
 			default: msg = "?";
 		}
 		// all this mess is just to get a different swipe direction for the first letter
-		char        btn = screen_swipe(get_glyph(msg[0]), dir,  PIXEL_DELAY, "UDAB");
-		if ( ! btn) btn = screen_scroll_once(msg + 1, LANG_DIR, PIXEL_DELAY, "UDAB");
-		if ( ! btn) btn = screen_swipe(0,             LANG_DIR, PIXEL_DELAY, "UDAB");
-		if ( ! btn) btn = screen_scroll_infinite(msg, LANG_DIR, PIXEL_DELAY, "UDAB");
+		const struct screen_strip_t *strip = screen_strip_get(msg, LANG_DIR, true);
+		char        btn = screen_swipe(get_glyph(msg[0]), dir,  PIXEL_DELAY, "U+D+AB");
+		if ( ! btn) btn = screen_strip_scroll(strip, strip->lead, PIXEL_DELAY, "U+D+AB");
+		if ( ! btn) btn = screen_swipe(0,             LANG_DIR, PIXEL_DELAY, "U+D+AB");
+		for (unsigned i = 0; i < MENU_IDLE_LOOPS && ! btn; i++) {
+			btn = screen_strip_scroll(strip, 0, PIXEL_DELAY, "U+D+AB");
+			if ( ! btn) btn = screen_swipe(0, strip->direction, PIXEL_DELAY, "U+D+AB");
+		}
+		if ( ! btn) {
+			screen_swipe(0, LANG_DIR, PIXEL_DELAY, "");
+			return MENU_ATTRACT;
+		}
 		unsigned menu_pos_step = ARRAY_SIZE(emenu_options);
 		switch(btn) {
 			case 'A':
@@ -84,24 +121,25 @@ uint8_t do_menu()
 	// never reached
 }
 
-bool show_score(uint8_t points)
+// rank in the highscore table, -1 for none; true to play again
+bool show_score(uint8_t game, unsigned points, int rank)
 {
-	char emsg[10] = "Score:";
-	char hmsg[20] = "ניקוד:";
-	// bidi-aware itoa
-	if (points < 10) {
-		emsg[6] = hmsg[11] = '0' + (points % 10);
-	} else {
-		emsg[6] = hmsg[12] = '0' + (points / 10);
-		emsg[7] = hmsg[11] = '0' + (points % 10);
-	}
-
-	char *msg;
-	switch(settings.lang) {
-		case LANG_EN: msg = emsg; break;
-		case LANG_HE: msg = hmsg; break;
-		default: msg = "?";
-	}
+	static const char * const prefix[] = {"Score:", "ניקוד:"};
+	static const char * const best[] = {"Best:", "שיא:"};
+	static const char * const new_best[] = {"New best!", "שיא חדש!"};
+	const struct highscore_table_t *hs = highscore_get(game);
+	const char *lang_prefix = settings.lang < LANG_END ? prefix[settings.lang] : "?";
+	char msg[48];
+	if (rank == 0)
+		snprintk(msg, sizeof(msg), "%s%u %s", lang_prefix, points,
+			new_best[settings.lang % LANG_END]);
+	else if (rank > 0)
+		snprintk(msg, sizeof(msg), "%s%u #%d", lang_prefix, points, rank + 1);
+	else if (hs && hs->n)
+		snprintk(msg, sizeof(msg), "%s%u %s%u", lang_prefix, points,
+			best[settings.lang % LANG_END], hs->score[0]);
+	else
+		snprintk(msg, sizeof(msg), "%s%u", lang_prefix, points);
 
 	char btn = screen_scroll_infinite(msg, LANG_DIR, PIXEL_DELAY, "AB");
 	return (btn == 'A');
@@ -172,7 +210,7 @@ bool do_settings_brightness(const struct device *led)
 
 	char dir = 'L';
 	while (1) {
-		const char *filter = brightness ? (brightness >= 15 ? "LAB" : "LRAB") : "RAB";
+		const char *filter = brightness ? (brightness >= 15 ? "L+AB" : "L+R+AB") : "R+AB";
 		char btn = screen_swipe(thin_number_glyph(brightness), dir, PIXEL_DELAY, filter);
 		if ( ! btn) btn = buttons_get(filter, K_FOREVER);
 		switch(btn) {
@@ -201,7 +239,7 @@ bool do_settings_speed()
 
 	char dir = 'L';
 	while (1) {
-		const char *filter = (speed <= 35) ? "LAB" : ((speed >= 110) ? "RAB" : "LRAB");
+		const char *filter = (speed <= 35) ? "L+AB" : ((speed >= 110) ? "R+AB" : "L+R+AB");
 		char btn = screen_swipe(thin_number_glyph(22-(speed / 5)), dir, PIXEL_DELAY, filter);
 		if ( ! btn) btn = buttons_get(filter, K_FOREVER);
 		switch(btn) {
@@ -222,19 +260,51 @@ bool do_settings_speed()
 }
 
 
+bool do_settings_orientation()
+{
+	unsigned int orientation = settings.orientation;
+
+	char dir = 'L';
+	while (1) {
+		// an asymmetric glyph, so mirroring shows
+		char btn = screen_swipe(get_glyph('F'), dir, PIXEL_DELAY, "LRAB");
+		if ( ! btn) btn = buttons_get("LRAB", K_FOREVER);
+		switch(btn) {
+			case 'L': orientation = (orientation + SCREEN_ORIENT_END - 1) % SCREEN_ORIENT_END; break;
+			case 'R': orientation = (orientation + 1) % SCREEN_ORIENT_END; break;
+			case 'A':
+				if (settings.orientation != orientation) {
+					settings.orientation = orientation;
+					return true;
+				}
+				// fall-through
+			case 'B':
+				screen_set_orientation(settings.orientation);
+				return false;
+		}
+		screen_set_orientation(orientation);
+
+		dir = btn;
+		printk("orientation=%u\n", orientation);
+	}
+}
+
+
 void do_settings_menu(const struct device *eeprom, const struct device *led)
 {
 	static const char * const emenu_options[] = {
 		"1.Language",
 		"2.Screen brightness",
 		"3.Scroll speed",
-		"4.Reset to default",
+		"4.Screen orientation",
+		"5.Reset to default",
 	};
 	static const char * const hmenu_options[] = { 
 		"1.שפה",
 		"2.בהירות מסך",
 		"3.מהירות תצוגה",
-		"4.חזרה לברירת מחדל",
+		"4.כיוון מסך",
+		"5.חזרה לברירת מחדל",
 	};
 	uint8_t menu_pos = 0;
 	const char *msg;
@@ -246,10 +316,11 @@ void do_settings_menu(const struct device *eeprom, const struct device *led)
 			default: msg = "?";
 		}
 		// all this mess is just to get a different swipe direction for the first letter
-		char        btn = screen_swipe(get_glyph(msg[0]), dir,  PIXEL_DELAY, "UDAB");
-		if ( ! btn) btn = screen_scroll_once(msg + 1, LANG_DIR, PIXEL_DELAY, "UDAB");
-		if ( ! btn) btn = screen_swipe(0,             LANG_DIR, PIXEL_DELAY, "UDAB");
-		if ( ! btn) btn = screen_scroll_infinite(msg, LANG_DIR, PIXEL_DELAY, "UDAB");
+		const struct screen_strip_t *strip = screen_strip_get(msg, LANG_DIR, true);
+		char        btn = screen_swipe(get_glyph(msg[0]), dir,  PIXEL_DELAY, "U+D+AB");
+		if ( ! btn) btn = screen_strip_scroll(strip, strip->lead, PIXEL_DELAY, "U+D+AB");
+		if ( ! btn) btn = screen_swipe(0,             LANG_DIR, PIXEL_DELAY, "U+D+AB");
+		if ( ! btn) btn = screen_strip_scroll_infinite(strip,   PIXEL_DELAY, "U+D+AB");
 		screen_swipe(0, LANG_DIR, PIXEL_DELAY, "");
 		unsigned menu_pos_step = ARRAY_SIZE(emenu_options);
 		switch(btn) {
@@ -257,11 +328,16 @@ void do_settings_menu(const struct device *eeprom, const struct device *led)
 			case 'U': --menu_pos_step; break;
 			case 'A':
 				bool save = false;
+				buttons_clear();
 				switch(menu_pos) {
 					case 0: save = do_settings_language(); break;
 					case 1: save = do_settings_brightness(led); break;
 					case 2: save = do_settings_speed(); break;
-					case 3: persist_reset_all(eeprom); break;
+					case 3: save = do_settings_orientation(); break;
+					case 4:
+						persist_reset_all(eeprom);
+						screen_set_orientation(settings.orientation);
+						break;
 				}
 				if (save) {
 					persist_save_settings(eeprom);
@@ -270,6 +346,8 @@ void do_settings_menu(const struct device *eeprom, const struct device *led)
 				break;
 				
 			case 'B': 
+				// saved before going back, where the board may be switched off
+				shadow_flush();
 				return;
 		}
 		dir = (btn == 'A') ? LANG_DIR : btn; // 'U' and 'D' remain
@@ -279,6 +357,55 @@ void do_settings_menu(const struct device *eeprom, const struct device *led)
 	// never reached
 }
 
+// play a game, recording it and its score; true to play again
+bool run_game(const struct device *eeprom, uint8_t game)
+{
+	replay_record_start(eeprom, game);
+	unsigned score = games[game]();
+	replay_record_stop(eeprom, score);
+	int rank = highscore_add(game, score);
+	shadow_flush(); // the score screen is a usual place to switch off
+	return show_score(game, score, rank);
+}
+
+// replay the best run of the next game that has one, or let the autopilot
+// play snake; a press takes over
+void do_attract(const struct device *eeprom)
+{
+	static uint8_t turn = 0;
+	for (unsigned i = 0; i <= N_GAMES; i++) {
+		turn = (turn + 1) % (N_GAMES + 1);
+		uint8_t game = turn;
+		unsigned score;
+		bool taken_over;
+		if (turn == N_GAMES) {
+			game = MENU_SNAKE;
+			score = play_snake_auto(&taken_over);
+		} else if (games[game] && replay_play_start(eeprom, game, REPLAY_REALTIME) == 0) {
+			score = games[game]();
+			taken_over = replay_play_stop();
+		} else
+			continue;
+		if (taken_over && show_score(game, score, -1))
+			while (run_game(eeprom, game)) {}
+		return;
+	}
+}
+
+#ifdef REPLAY_BENCHMARK
+// replay the best runs at full speed; replay_play_stop() prints the time
+void replay_benchmark(const struct device *eeprom)
+{
+	for (unsigned game = 0; game < N_GAMES; game++) {
+		if ( ! games[game] || replay_play_start(eeprom, game, REPLAY_FULL_SPEED) < 0)
+			continue;
+		unsigned score = games[game]();
+		replay_play_stop();
+		printk("[%s] game=%u score=%u\n", __func__, game, score);
+	}
+}
+#endif
+
 int main(void)
 {
 	printk("Hello World %s! [%s]\n", CONFIG_BOARD, __TIMESTAMP__);
@@ -300,35 +427,60 @@ int main(void)
 	}
 
 	persist_load_settings(eeprom);
+	highscore_init();
+	fontpack_init(eeprom);
+	latency_init();
+	kc_init();
 
 	led_set_brightness(led, 0, settings.brightness*100/15);
+	screen_set_orientation(settings.orientation);
 
 	boot_animation();
+#ifdef REPLAY_BENCHMARK
+	replay_benchmark(eeprom);
+#endif
+#ifdef SNAKE_BENCHMARK
+	snake_benchmark(SNAKE_BENCHMARK);
+#endif
+#ifdef LIFE_BENCHMARK
+	life_benchmark(LIFE_BENCHMARK);
+#endif
 
 	while (1) {
 		uint8_t choice = do_menu();
 		printk("Menu selection: %d\n", choice);
+		buttons_clear();
 
 		switch(choice) {
 			case MENU_SNAKE:
-				while(show_score(play_snake())) {}
+				while(run_game(eeprom, MENU_SNAKE)) {}
 				break;
 
 			case MENU_SIMON:
-				while(show_score(play_simon())) {}
+				while(run_game(eeprom, MENU_SIMON)) {}
 				break;
 
 			case MENU_PONG:
-				//while(show_score(play_pong())) {}
-				//break;
-				const char *msg[] = {"Not implemented", "טרם מומש"};
-				screen_scroll_once(msg[settings.lang], LANG_DIR, PIXEL_DELAY, "AB");
+				while(run_game(eeprom, MENU_PONG)) {}
+				break;
+
+			case MENU_BLOCKS:
+				while(run_game(eeprom, MENU_BLOCKS)) {}
+				break;
+
+			case MENU_LIFE:
+				play_life();
 				break;
 
 			case MENU_SETTINGS:
 				do_settings_menu(eeprom, led);
 				break;
+
+			case MENU_ATTRACT:
+				do_attract(eeprom);
+				break;
 		}
+		screen_print_stats();
 	}
 
 	return 0;
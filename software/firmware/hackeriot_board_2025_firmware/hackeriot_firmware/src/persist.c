@@ -6,83 +6,223 @@
  */
 
 #include <zephyr/drivers/eeprom.h>
+#include <zephyr/sys/crc.h>
 #include <zephyr/sys/printk.h>
 
+#include "highscore.h"
 #include "persist.h"
+#include "shadow.h"
 
 #define		DEFAULT_BRIGHTNESS	10
 #define		DEFAULT_LANG		LANG_HE
 #define		DEFAULT_SPEED		70
+#define		DEFAULT_ORIENTATION	0	// SCREEN_ORIENT_0
+
+#define		SETTINGS_MAGIC		0x5354	/* 'ST' */
+#define		SETTINGS_VERSION	1
+#define		SETTINGS_RECORD_SIZE	16
+#define		SETTINGS_SLOTS		(EEPROM_SETTINGS_PAGES * EEPROM_PAGE_SIZE / SETTINGS_RECORD_SIZE)
+#define		MIN_SPEED			40
 
 struct eeprom_settings_t settings = {
-	.magic = EEPROM_MAGIC,
 	.brightness = DEFAULT_BRIGHTNESS,
 	.lang = DEFAULT_LANG,
 	.speed = DEFAULT_SPEED,
+	.orientation = DEFAULT_ORIENTATION,
 };
 
-void persist_load_settings(const struct device *eeprom)
+// Settings are saved by appending a record to a log over
+// EEPROM_SETTINGS_PAGES pages. Consecutive slots are on different pages,
+// so a torn write cannot take the previous record with it, and every page
+// wears at the same rate. Boot loads the valid record with the highest
+// sequence number.
+struct settings_record_t {
+	uint16_t	magic;
+	uint8_t		version;	// of the layout of data
+	uint8_t		len;		// bytes of data used
+	uint32_t	seq;		// one more than the previous record
+	uint8_t		data[6];	// by enum settings_field
+	uint16_t	crc;		// CRC-16/CCITT of all the above
+};
+
+BUILD_ASSERT(sizeof(struct settings_record_t) == SETTINGS_RECORD_SIZE);
+BUILD_ASSERT(EEPROM_PAGE_SIZE % SETTINGS_RECORD_SIZE == 0);
+
+// New fields are appended, so older records lack them and these keep
+// their defaults; any other change bumps SETTINGS_VERSION and adds a case
+// to settings_decode() converting the older layout.
+enum settings_field {
+	FIELD_LANG = 0,
+	FIELD_BRIGHTNESS,
+	FIELD_SPEED,
+	FIELD_ORIENTATION,
+	FIELD_END /* keep last */
+};
+
+BUILD_ASSERT(FIELD_END <= sizeof(((struct settings_record_t *)0)->data));
+BUILD_ASSERT(EEPROM_SETTINGS_OFFSET + EEPROM_SETTINGS_PAGES * EEPROM_PAGE_SIZE <=
+	EEPROM_SHADOW_OFFSET + EEPROM_SHADOW_SIZE, "the log is read from the shadow");
+
+// the settings at offset 0, before the log
+struct legacy_settings_t {
+	uint32_t		magic;
+	unsigned int	lang		: 3;
+	unsigned int	brightness	: 4;
+	unsigned int	speed		: 7;
+	unsigned int	orientation	: 3;
+};
+
+static uint32_t settings_seq;		// of the newest record, 0 for none
+static unsigned settings_slot = SETTINGS_SLOTS - 1;
+
+static unsigned settings_offset(unsigned slot)
 {
-	printk("EEPROM size=%zu.\n", eeprom_get_size(eeprom));
+	unsigned page = slot % EEPROM_SETTINGS_PAGES;
+	unsigned idx  = slot / EEPROM_SETTINGS_PAGES;
+	return EEPROM_SETTINGS_OFFSET + page * EEPROM_PAGE_SIZE + idx * SETTINGS_RECORD_SIZE;
+}
 
-	int rc = eeprom_read(eeprom, 0, &settings, sizeof(settings));
-	if (rc < 0) {
-		printk("[%s] header read error; code=%d.\n", __func__, rc);
+static uint16_t settings_crc(const struct settings_record_t *rec)
+{
+	return crc16_ccitt(0xFFFF, (const uint8_t *)rec, offsetof(struct settings_record_t, crc));
+}
+
+static void settings_defaults()
+{
+	settings.brightness = DEFAULT_BRIGHTNESS;
+	settings.lang = DEFAULT_LANG;
+	settings.speed = DEFAULT_SPEED;
+	settings.orientation = DEFAULT_ORIENTATION;
+}
+
+static bool settings_decode(const struct settings_record_t *rec)
+{
+	switch (rec->version) {
+		case 1:
+			settings_defaults();
+			if (rec->len > FIELD_LANG)			settings.lang = rec->data[FIELD_LANG];
+			if (rec->len > FIELD_BRIGHTNESS)	settings.brightness = rec->data[FIELD_BRIGHTNESS];
+			if (rec->len > FIELD_SPEED)			settings.speed = rec->data[FIELD_SPEED];
+			if (rec->len > FIELD_ORIENTATION)	settings.orientation = rec->data[FIELD_ORIENTATION];
+			return true;
+
+		default: // from a newer firmware
+			return false;
+	}
+}
+
+static void settings_validate()
+{
+	// validate language
+	if (settings.lang >= LANG_END) {
+		printk("[%s] invalid lang %d.\n", __func__, settings.lang);
+		settings.lang = DEFAULT_LANG;
+	}
+	// validate brightness
+	if (settings.brightness == 0) {
+		printk("[%s] invalid brightness %d.\n", __func__, settings.brightness);
+		settings.brightness = DEFAULT_BRIGHTNESS;
+	}
+	// validate speed
+	if (settings.speed < MIN_SPEED) {
+		printk("[%s] invalid speed %d.\n", __func__, settings.speed);
+		settings.speed = MIN_SPEED;
 	}
-	if (settings.magic == EEPROM_MAGIC) {
-		// validate language
-		if (settings.lang >= LANG_END) {
-    		printk("[%s] invalid lang %d.\n", __func__, settings.lang);
-			settings.lang = LANG_HE;
+}
+
+// newest valid record into rec; false if none
+static bool settings_scan(struct settings_record_t *rec)
+{
+	struct settings_record_t page[EEPROM_PAGE_SIZE / SETTINGS_RECORD_SIZE];
+
+	settings_seq = 0;
+	settings_slot = SETTINGS_SLOTS - 1;
+	for (unsigned p = 0; p < EEPROM_SETTINGS_PAGES; p++) {
+		int rc = shadow_read(settings_offset(p), page, sizeof(page));
+		if (rc < 0) {
+			printk("[%s] read error; page=%u code=%d.\n", __func__, p, rc);
+			continue;
 		}
-		// validate speed
-		if (settings.speed < 40) {
-    		printk("[%s] invalid speed %d.\n", __func__, settings.speed);
-			settings.speed = 40;
+		for (unsigned i = 0; i < ARRAY_SIZE(page); i++) {
+			if (page[i].magic != SETTINGS_MAGIC || page[i].len > sizeof(page[i].data) ||
+				page[i].crc != settings_crc(&page[i]))
+				continue;
+			if (settings_seq && (int32_t)(page[i].seq - settings_seq) <= 0)
+				continue;
+			settings_seq = page[i].seq;
+			settings_slot = i * EEPROM_SETTINGS_PAGES + p;
+			*rec = page[i];
 		}
+	}
+	return settings_seq != 0;
+}
+
+void persist_load_settings(const struct device *eeprom)
+{
+	printk("EEPROM size=%zu.\n", eeprom_get_size(eeprom));
+	shadow_init(eeprom);
 
+	struct settings_record_t rec;
+	struct legacy_settings_t legacy;
+	if (settings_scan(&rec)) {
+		if ( ! settings_decode(&rec)) {
+			printk("[%s] unknown version %u; using defaults.\n", __func__, rec.version);
+			settings_defaults();
+		}
+	} else if (eeprom_read(eeprom, 0, &legacy, sizeof(legacy)) == 0 &&
+		legacy.magic == EEPROM_MAGIC) {
+		printk("[%s] migrating settings to the log.\n", __func__);
+		settings.lang = legacy.lang;
+		settings.brightness = legacy.brightness;
+		settings.speed = legacy.speed;
+		settings.orientation = legacy.orientation;
+		settings_validate();
+		persist_save_settings(eeprom);
 	} else {
-		printk("[%s] magic not found; resetting EEPROM.\n", __func__);
+		printk("[%s] no settings found; resetting EEPROM.\n", __func__);
 		persist_reset_all(eeprom);
 	}
+	settings_validate();
 }
 
 void persist_save_settings(const struct device *eeprom)
 {
-	int rc = eeprom_write(eeprom, 0, &settings, sizeof(settings));
+	struct settings_record_t rec = {
+		.magic = SETTINGS_MAGIC,
+		.version = SETTINGS_VERSION,
+		.len = FIELD_END,
+		.seq = settings_seq + 1,
+		.data = {
+			[FIELD_LANG] = settings.lang,
+			[FIELD_BRIGHTNESS] = settings.brightness,
+			[FIELD_SPEED] = settings.speed,
+			[FIELD_ORIENTATION] = settings.orientation,
+		},
+	};
+	rec.crc = settings_crc(&rec);
+
+	unsigned slot = (settings_slot + 1) % SETTINGS_SLOTS;
+	int rc = shadow_write(settings_offset(slot), &rec, sizeof(rec));
 	if (rc < 0) {
 		printk("[%s] write error; code=%d.\n", __func__, rc);
+		return;
 	}
-}
-
-void persist_save_highscore(const struct device *eeprom, uint8_t idx,
-    const struct highscore_t *hs)
-{
-    int rc = eeprom_write(eeprom, EEPROM_HS_OFFSET + idx * sizeof(*hs),
-        hs, sizeof(*hs));
-    if (rc < 0) {
-        printk("[%s] write error; idx=%u code=%d.\n", __func__, idx, rc);
-    }
+	settings_seq = rec.seq;
+	settings_slot = slot;
 }
 
 void persist_reset_all(const struct device *eeprom)
 {
-	struct highscore_t hs = {
-		.play_count	= 0,
-		.score 		= 1,
-		.lang		= LANG_HE,
-		.name		= "מהממת",
-	};
-
 	// reset highscores
-	for (unsigned i = 0; i < N_GAMES; i++)
-        persist_save_highscore(eeprom, i, &hs);
+	highscore_reset_all();
 
 	// reset settings
-	settings.magic = EEPROM_MAGIC;
-	settings.brightness = DEFAULT_BRIGHTNESS;
-	settings.lang = DEFAULT_LANG;
-	settings.speed = DEFAULT_SPEED;
+	settings_defaults();
 	persist_save_settings(eeprom);
+
+	// the board is often switched off right after a reset
+	int rc = shadow_flush();
+	if (rc < 0)
+		printk("[%s] write error; code=%d.\n", __func__, rc);
 }
 
@@ -17,29 +17,29 @@ enum language {
 };
 
 extern struct eeprom_settings_t {
-	uint32_t		magic;
 	unsigned int	lang		: 3;	// actual type: enum language
 	unsigned int	brightness	: 4;	// 1 to 15
 	unsigned int	speed		: 7;	// scroll speed in ms, higher is slower
+	unsigned int	orientation	: 3;	// actual type: enum screen_orientation
 } settings;
 
-struct highscore_t {
-	unsigned int	play_count	: 20;
-	unsigned int	score		: 9;
-	unsigned int	lang		: 3;	// actual type: enum language
-	char			name[28];
-};
-
-#define N_GAMES				3
-#define EEPROM_HS_OFFSET    32
-#define EEPROM_MAGIC        0x48485257UL /* 'HHRW' */
+#define N_GAMES				4
+#define EEPROM_PAGE_SIZE    64      // AT24C256 write page
+#define EEPROM_SHADOW_OFFSET 0x0040 // written behind, see shadow.h
+#define EEPROM_SHADOW_SIZE  0x0200  // the highscores and the settings log
+#define EEPROM_HS_OFFSET    0x0040  // a page per game, see highscore.h
+#define EEPROM_SETTINGS_OFFSET 0x0140 // settings log after them, see persist.c
+#define EEPROM_SETTINGS_PAGES  4
+#define EEPROM_REPLAY_OFFSET 0x1000 // best run per game, then a scratch slot, see replay.h
+#define EEPROM_REPLAY_SLOT  0x980   // 38 pages, (N_GAMES + 1) slots fit before the font
+#define EEPROM_FONT_OFFSET  0x4000  // font pack, see fontpack.h
+#define EEPROM_FONT_SIZE    0x4000
+#define EEPROM_MAGIC        0x48485257UL /* 'HHRW', settings at 0 before the log */
 #define LANG_DIR			"LR"[settings.lang]
 #define PIXEL_DELAY			K_MSEC(settings.speed)
 
 void persist_load_settings(const struct device *eeprom);
 void persist_save_settings(const struct device *eeprom);
-void persist_save_highscore(const struct device *eeprom, uint8_t idx,
-    const struct highscore_t *hs);
 void persist_reset_all(const struct device *eeprom);
 
 #endif // __PERSISTENCE_H__
\ No newline at end of file
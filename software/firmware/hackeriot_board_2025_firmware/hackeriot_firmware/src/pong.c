@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2025 Benny Meisels <benny.meisels@gmail.com>
+ *                    Rani Hod <rani.hod@gmail.com>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/sys/printk.h>
+
+#include "bitboard.h"
+#include "game.h"
+#include "pong.h"
+#include "replay.h"
+#include "screen.h"
+
+#define PLAYER_COL	0
+#define CPU_COL		7
+#define PADDLE_MAX	Q8(8 - PONG_PADDLE_LEN)
+
+// CPU difficulty levels, the next one every PONG_POINTS_PER_LEVEL points
+static const struct pong_cpu_t {
+	q8_t	speed;		// paddle pixels per update
+	uint8_t	reaction;	// columns away from its paddle it starts to follow the ball
+	q8_t	error;		// largest random aim offset
+} pong_cpu_levels[] = {
+	{ 0x10, 3, Q8(2) },
+	{ 0x18, 4, Q8(1) },
+	{ 0x20, 5, 0x80 },
+	{ 0x30, 6, 0x40 },
+	{ 0x40, 7, 0 },
+};
+
+static q8_t clamp(q8_t x, q8_t lo, q8_t hi)
+{
+	return (x < lo) ? lo : (x > hi) ? hi : x;
+}
+
+// a random value in [-range, range]
+static q8_t random_offset(q8_t range)
+{
+	return range ? (q8_t)(replay_rand32() % (2 * range + 1)) - range : 0;
+}
+
+static void serve(struct pong_data_t *pd, bool to_player)
+{
+	pd->ball_x = Q8(CPU_COL + PLAYER_COL) / 2 + Q8_HALF;
+	pd->ball_y = Q8(replay_rand8() % 4 + 2);
+	pd->ball_vx = to_player ? -PONG_BALL_SPEED : PONG_BALL_SPEED;
+	pd->ball_vy = random_offset(PONG_SPIN);
+}
+
+// move a paddle towards target (its center row), at most speed
+static void paddle_follow(q8_t *y, q8_t target, q8_t speed)
+{
+	q8_t delta = clamp(target - Q8(PONG_PADDLE_LEN - 1) / 2 - *y, -speed, speed);
+	*y = clamp(*y + delta, 0, PADDLE_MAX);
+}
+
+// bounces the ball off the paddle at y if it covers the ball's row
+static bool paddle_hit(struct pong_data_t *pd, q8_t y)
+{
+	int offset = Q8_ROUND(pd->ball_y) - Q8_ROUND(y); // 0 to PONG_PADDLE_LEN - 1 on it
+	if (offset < 0 || offset >= PONG_PADDLE_LEN)
+		return false;
+
+	// faster with each hit; steeper off the paddle ends
+	q8_t speed = (pd->ball_vx < 0) ? -pd->ball_vx : pd->ball_vx;
+	speed = MIN(speed + speed / 16, PONG_BALL_MAX);
+	pd->ball_vx = (pd->ball_vx < 0) ? speed : -speed;
+	pd->ball_vy = clamp(pd->ball_vy + (offset - (PONG_PADDLE_LEN - 1) / 2) * PONG_SPIN,
+		-PONG_BALL_MAX, PONG_BALL_MAX);
+	return true;
+}
+
+// one fixed step; returns false when a point was scored
+static bool pong_step(struct pong_data_t *pd)
+{
+	const struct pong_cpu_t *cpu = &pong_cpu_levels[MIN(pd->points / PONG_POINTS_PER_LEVEL,
+		ARRAY_SIZE(pong_cpu_levels) - 1)];
+
+	// player
+	if (pd->up != pd->down)
+		pd->player_y = clamp(pd->player_y + (pd->up ? PONG_PADDLE_SPEED : -PONG_PADDLE_SPEED),
+			0, PADDLE_MAX);
+
+	// CPU: follows the ball coming its way once close enough, else centers
+	if (pd->ball_vx > 0 && pd->ball_x >= Q8(CPU_COL - cpu->reaction))
+		paddle_follow(&pd->cpu_y, pd->ball_y + pd->cpu_aim, cpu->speed);
+	else
+		paddle_follow(&pd->cpu_y, Q8(7) / 2, cpu->speed / 2);
+
+	// ball, reflected off the top and bottom rows
+	pd->ball_x += pd->ball_vx;
+	pd->ball_y += pd->ball_vy;
+	if (pd->ball_y < 0) {
+		pd->ball_y = -pd->ball_y;
+		pd->ball_vy = -pd->ball_vy;
+	} else if (pd->ball_y > Q8(7)) {
+		pd->ball_y = 2 * Q8(7) - pd->ball_y;
+		pd->ball_vy = -pd->ball_vy;
+	}
+
+	// paddles
+	if (pd->ball_vx < 0 && pd->ball_x <= Q8(PLAYER_COL + 1)) {
+		if ( ! paddle_hit(pd, pd->player_y)) {
+			++pd->misses;
+			printk("[%s] player missed; %u:%u\n", __func__, pd->points, pd->misses);
+			return false;
+		}
+		pd->ball_x = 2 * Q8(PLAYER_COL + 1) - pd->ball_x;
+		pd->cpu_aim = random_offset(cpu->error);
+	} else if (pd->ball_vx > 0 && pd->ball_x >= Q8(CPU_COL - 1)) {
+		if ( ! paddle_hit(pd, pd->cpu_y)) {
+			++pd->points;
+			printk("[%s] CPU missed; %u:%u\n", __func__, pd->points, pd->misses);
+			return false;
+		}
+		pd->ball_x = 2 * Q8(CPU_COL - 1) - pd->ball_x;
+	}
+	return true;
+}
+
+static uint64_t paddle_bitmap(q8_t y, unsigned col)
+{
+	uint64_t column = BB_COLUMN(col) & (BB_BIT(BB_POS(PONG_PADDLE_LEN, 0)) - 1);
+	return column << (8 * Q8_ROUND(y));
+}
+
+static void pong_input(void *state, char btn)
+{
+	struct pong_data_t *pd = state;
+	switch (btn) {
+		case 'U': pd->up = true; break;
+		case 'u': pd->up = false; break;
+		case 'D': pd->down = true; break;
+		case 'd': pd->down = false; break;
+	}
+}
+
+// after a point, the ball waits PONG_SERVE_DELAY where it went out
+static bool pong_update(void *state)
+{
+	struct pong_data_t *pd = state;
+	if (pd->serve_ticks) {
+		if (--pd->serve_ticks)
+			return true;
+		if (pd->misses >= PONG_LIVES)
+			return false;
+		serve(pd, pd->ball_vx > 0);
+		return true;
+	}
+	if ( ! pong_step(pd))
+		pd->serve_ticks = PONG_SERVE_DELAY * PONG_HZ / 1000;
+	return true;
+}
+
+static void pong_render(const void *state)
+{
+	const struct pong_data_t *pd = state;
+	screen_begin();
+	screen_set(paddle_bitmap(pd->player_y, PLAYER_COL) | paddle_bitmap(pd->cpu_y, CPU_COL));
+	if (pd->serve_ticks)
+		screen_pixel_blink(BB_POS(clamp(Q8_ROUND(pd->ball_y), 0, 7),
+			pd->ball_vx < 0 ? PLAYER_COL : CPU_COL), true);
+	else
+		screen_pixel_on(BB_POS(Q8_ROUND(pd->ball_y), Q8_ROUND(pd->ball_x)));
+	screen_commit();
+}
+
+static uint32_t pong_tick_ms(const void *state)
+{
+	return 1000 / PONG_HZ;
+}
+
+static const struct game_t pong = {
+	.name		= "pong",
+	.buttons	= "UuDd",
+	.input		= pong_input,
+	.update		= pong_update,
+	.render		= pong_render,
+	.tick_ms	= pong_tick_ms,
+};
+
+unsigned play_pong()
+{
+	printk("[%s] new game\n", __func__);
+
+	struct pong_data_t pd = {
+		.player_y = PADDLE_MAX / 2,
+		.cpu_y = PADDLE_MAX / 2,
+	};
+	serve(&pd, true);
+	game_run(&pong, &pd, GAME_REALTIME);
+	screen_set(0);
+
+	printk("[%s] game ended, score=%u\n", __func__, pd.points);
+	return pd.points;
+}
@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) 2025 Benny Meisels <benny.meisels@gmail.com>
+ *                    Rani Hod <rani.hod@gmail.com>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef __PONG_H__
+#define __PONG_H__
+
+#include <zephyr/kernel.h>
+
+// Positions and velocities are Q8.8 fixed point, in pixels and pixels per
+// update; a pixel is at the integer part rounded. The player's paddle is
+// the right column, the CPU's the left one.
+typedef int16_t q8_t;
+#define Q8(n)			((q8_t)((n) << 8))
+#define Q8_HALF			0x80
+#define Q8_ROUND(x)		(((x) + Q8_HALF) >> 8)
+
+#define PONG_HZ				50		// updates per second
+#define PONG_LIVES			3		// CPU points that end the game
+#define PONG_PADDLE_LEN		3
+#define PONG_PADDLE_SPEED	0x40	// pixels per update, 12.5 per second
+#define PONG_BALL_SPEED		0x30	// horizontal, at a serve
+#define PONG_BALL_MAX		0xC0	// under a pixel per update, for collisions
+#define PONG_SPIN			0x18	// vertical speed per row off the paddle center
+#define PONG_SERVE_DELAY	700		// ms
+#define PONG_POINTS_PER_LEVEL 3		// player points per CPU difficulty level
+
+struct pong_data_t {
+	q8_t ball_x, ball_y;
+	q8_t ball_vx, ball_vy;
+	q8_t player_y, cpu_y;	// lowest row of each paddle
+	q8_t cpu_aim;			// offset from the ball the CPU aims at
+	uint8_t points;
+	uint8_t misses;
+	uint8_t serve_ticks;	// left before the next serve, 0 in play
+	bool up, down;			// D-pad held
+};
+
+unsigned play_pong();
+
+#endif // __PONG_H__
@@ -0,0 +1,346 @@
+/*
+ * Copyright (c) 2025 Benny Meisels <benny.meisels@gmail.com>
+ *                    Rani Hod <rani.hod@gmail.com>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <limits.h>
+
+#include <zephyr/drivers/eeprom.h>
+#include <zephyr/random/random.h>
+#include <zephyr/sys/printk.h>
+
+#include "replay.h"
+
+BUILD_ASSERT(EEPROM_REPLAY_OFFSET + (N_GAMES + 1) * EEPROM_REPLAY_SLOT <= EEPROM_FONT_OFFSET);
+BUILD_ASSERT(EEPROM_REPLAY_OFFSET % EEPROM_PAGE_SIZE == 0 &&
+	EEPROM_REPLAY_SLOT % EEPROM_PAGE_SIZE == 0);
+
+#define REPLAY_FILLER   0xFF    // event byte of a record of skipped << 8 timeouts only
+
+struct replay_header_t {
+	uint32_t	magic;
+	uint32_t	seed;
+	uint16_t	n_events;
+	uint16_t	score;
+	uint8_t		game;
+	uint8_t		speed;		// settings.speed of the run
+	uint8_t		reserved[2];
+};
+
+struct replay_event_t {
+	uint8_t		skipped;	// input reads that timed out before this one
+	uint8_t		event;		// key | gesture << 3 | pressed << 5
+};
+
+BUILD_ASSERT(sizeof(struct replay_header_t) == REPLAY_HEADER_SIZE);
+BUILD_ASSERT(sizeof(struct replay_event_t) == REPLAY_EVENT_SIZE);
+
+// Records stream through one EEPROM page: a run is recorded into the
+// scratch slot after the games' slots, and copied to its game's slot
+// when it is kept. Playing reads in the page of the next record.
+static struct replay_header_t replay_hdr;
+static struct replay_event_t replay_page[EEPROM_PAGE_SIZE / REPLAY_EVENT_SIZE];
+static unsigned replay_page_start = UINT_MAX;	// slot offset of replay_page, if loaded
+static const struct device *replay_eeprom;
+
+static enum {
+	REPLAY_OFF = 0,
+	REPLAY_RECORDING,
+	REPLAY_PLAYING,
+} replay_mode;
+static enum replay_speed replay_speed;
+static unsigned replay_pos;			// next record
+static uint32_t replay_skipped;		// timeouts since the last record
+static bool replay_truncated;
+static bool replay_taken_over;
+static uint32_t replay_start;		// k_uptime_get_32()
+static uint8_t replay_saved_speed;	// settings.speed to restore after playing
+
+static uint32_t replay_rng = 1;
+
+// xorshift32; never 0
+uint32_t replay_rand32()
+{
+	uint32_t x = replay_rng;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	return replay_rng = x;
+}
+
+static void replay_seed(uint32_t seed)
+{
+	replay_rng = seed ? seed : 1;
+}
+
+static uint8_t replay_encode(const struct buttons_event_t *evt)
+{
+	return evt->key | (evt->gesture << 3) | (evt->pressed << 5);
+}
+
+static void replay_decode(uint8_t event, struct buttons_event_t *evt)
+{
+	evt->cycles = k_cycle_get_32();
+	evt->key = event & 7;
+	evt->gesture = (event >> 3) & 3;
+	evt->pressed = (event >> 5) & 1;
+}
+
+static unsigned replay_slot(uint8_t game)
+{
+	return EEPROM_REPLAY_OFFSET + game * EEPROM_REPLAY_SLOT;
+}
+
+#define REPLAY_SCRATCH	replay_slot(N_GAMES)
+
+// slot offset of a record, and of the page it is in
+static unsigned replay_event_offset(unsigned i)
+{
+	return REPLAY_HEADER_SIZE + i * REPLAY_EVENT_SIZE;
+}
+#define REPLAY_PAGE_OF(offset)	((offset) & ~(EEPROM_PAGE_SIZE - 1))
+
+// write the records of the page being recorded, up to record n
+static void replay_flush(unsigned n)
+{
+	unsigned end = replay_event_offset(n);
+	unsigned start = MAX(REPLAY_PAGE_OF(end - 1), REPLAY_HEADER_SIZE);
+	if (end <= start)
+		return;
+	const uint8_t *page = (const uint8_t *)replay_page;
+	int rc = eeprom_write(replay_eeprom, REPLAY_SCRATCH + start,
+		page + start % EEPROM_PAGE_SIZE, end - start);
+	if (rc < 0) {
+		printk("[%s] write error; code=%d.\n", __func__, rc);
+		replay_truncated = true;
+	}
+}
+
+static void replay_append(uint8_t skipped, uint8_t event)
+{
+	unsigned n = replay_hdr.n_events;
+	if (n == REPLAY_MAX_EVENTS || replay_truncated) {
+		replay_truncated = true;
+		return;
+	}
+	unsigned offset = replay_event_offset(n);
+	struct replay_event_t *r = &replay_page[offset % EEPROM_PAGE_SIZE / REPLAY_EVENT_SIZE];
+	r->skipped = skipped;
+	r->event = event;
+	replay_hdr.n_events = ++n;
+	// a full page goes out at once; a game tick waits for it, every
+	// EEPROM_PAGE_SIZE / REPLAY_EVENT_SIZE inputs
+	if (replay_event_offset(n) % EEPROM_PAGE_SIZE == 0)
+		replay_flush(n);
+}
+
+// the record i of the slot being played, reading its page when needed
+static const struct replay_event_t *replay_load(unsigned i)
+{
+	unsigned offset = replay_event_offset(i);
+	unsigned start = REPLAY_PAGE_OF(offset);
+	if (start != replay_page_start) {
+		unsigned from = MAX(start, REPLAY_HEADER_SIZE);
+		unsigned to = MIN(start + EEPROM_PAGE_SIZE, replay_event_offset(replay_hdr.n_events));
+		uint8_t *page = (uint8_t *)replay_page;
+		int rc = eeprom_read(replay_eeprom, replay_slot(replay_hdr.game) + from,
+			page + from % EEPROM_PAGE_SIZE, to - from);
+		if (rc < 0) {
+			printk("[%s] read error; code=%d.\n", __func__, rc);
+			return NULL;
+		}
+		replay_page_start = start;
+	}
+	return &replay_page[offset % EEPROM_PAGE_SIZE / REPLAY_EVENT_SIZE];
+}
+
+// timeouts before a record, counting a filler's in blocks of 256
+static uint32_t replay_skips(const struct replay_event_t *r)
+{
+	return (r->event == REPLAY_FILLER) ? (uint32_t)r->skipped << 8 : r->skipped;
+}
+
+void replay_record(const struct buttons_event_t *evt)
+{
+	if (replay_mode != REPLAY_RECORDING)
+		return;
+	if ( ! evt) {
+		++replay_skipped; // one per game tick, at least
+		return;
+	}
+	// a long gap costs one filler record, not one per 255 ticks
+	while (replay_skipped > UINT8_MAX) {
+		uint32_t blocks = MIN(replay_skipped >> 8, UINT8_MAX);
+		replay_append(blocks, REPLAY_FILLER);
+		replay_skipped -= blocks << 8;
+	}
+	replay_append(replay_skipped, replay_encode(evt));
+	replay_skipped = 0;
+}
+
+void replay_record_start(const struct device *eeprom, uint8_t game)
+{
+	replay_hdr = (struct replay_header_t) {
+		.magic = REPLAY_MAGIC,
+		.seed = sys_rand32_get(),
+		.game = game,
+		.speed = settings.speed,
+	};
+	replay_seed(replay_hdr.seed);
+	replay_eeprom = eeprom;
+	replay_page_start = UINT_MAX;
+	replay_skipped = 0;
+	replay_truncated = false;
+	replay_mode = REPLAY_RECORDING;
+}
+
+// copy a slot's records, a page at a time, through replay_page
+static int replay_copy(unsigned from_slot, unsigned to_slot, unsigned n_events)
+{
+	unsigned end = replay_event_offset(n_events);
+	uint8_t *page = (uint8_t *)replay_page;
+	replay_page_start = UINT_MAX;
+	for (unsigned offset = REPLAY_HEADER_SIZE; offset < end; ) {
+		unsigned size = MIN(REPLAY_PAGE_OF(offset) + EEPROM_PAGE_SIZE, end) - offset;
+		int rc = eeprom_read(replay_eeprom, from_slot + offset, page, size);
+		if (rc == 0)
+			rc = eeprom_write(replay_eeprom, to_slot + offset, page, size);
+		if (rc < 0)
+			return rc;
+		offset += size;
+	}
+	return 0;
+}
+
+static void replay_print()
+{
+	const struct replay_header_t *hdr = &replay_hdr;
+	printk("replay: game=%u seed=%08x speed=%u score=%u events=%u%s\n", hdr->game,
+		hdr->seed, hdr->speed, hdr->score, hdr->n_events,
+		replay_truncated ? " (truncated)" : "");
+#ifdef REPLAY_BENCHMARK
+	// the whole log, for bug reports; too slow on the console for every game
+	uint8_t p[16];
+	unsigned size = hdr->n_events * REPLAY_EVENT_SIZE;
+	for (unsigned i = 0; i < size; i += sizeof(p)) {
+		unsigned n = MIN(size - i, sizeof(p));
+		if (eeprom_read(replay_eeprom, REPLAY_SCRATCH + REPLAY_HEADER_SIZE + i, p, n) < 0)
+			break;
+		for (unsigned j = 0; j < n; j++)
+			printk("%02x%s", p[j], (j == n - 1) ? "\n" : "");
+	}
+#endif
+}
+
+void replay_record_stop(const struct device *eeprom, unsigned score)
+{
+	if (replay_mode != REPLAY_RECORDING)
+		return;
+	replay_mode = REPLAY_OFF;
+	if (replay_event_offset(replay_hdr.n_events) % EEPROM_PAGE_SIZE)
+		replay_flush(replay_hdr.n_events); // the last, partial page
+	replay_hdr.score = score;
+	replay_print();
+	if (replay_truncated || ! score)
+		return;
+
+	// keep it if it beats the stored run
+	unsigned offset = replay_slot(replay_hdr.game);
+	struct replay_header_t stored;
+	int rc = eeprom_read(eeprom, offset, &stored, sizeof(stored));
+	if (rc == 0 && stored.magic == REPLAY_MAGIC && stored.score >= score)
+		return;
+	// straight to the EEPROM, not through the shadow: a slot is too big to
+	// keep in RAM, and a new best run is rare enough to wait for. The
+	// header goes last, so a cut copy leaves no run rather than a bad one.
+	stored.magic = 0;
+	rc = eeprom_write(eeprom, offset, &stored.magic, sizeof(stored.magic));
+	if (rc == 0)
+		rc = replay_copy(REPLAY_SCRATCH, offset, replay_hdr.n_events);
+	if (rc == 0)
+		rc = eeprom_write(eeprom, offset, &replay_hdr, sizeof(replay_hdr));
+	if (rc < 0)
+		printk("[%s] write error; code=%d.\n", __func__, rc);
+}
+
+int replay_play_start(const struct device *eeprom, uint8_t game,
+	enum replay_speed speed)
+{
+	int rc = eeprom_read(eeprom, replay_slot(game), &replay_hdr, sizeof(replay_hdr));
+	if (rc < 0)
+		return rc;
+	if (replay_hdr.magic != REPLAY_MAGIC || replay_hdr.game != game ||
+		replay_hdr.n_events > REPLAY_MAX_EVENTS || ! replay_hdr.speed)
+		return -ENOENT;
+
+	printk("[%s] game=%u score=%u %s\n", __func__, game, replay_hdr.score,
+		speed == REPLAY_FULL_SPEED ? "full speed" : "real time");
+	replay_seed(replay_hdr.seed);
+	replay_eeprom = eeprom;
+	replay_page_start = UINT_MAX;
+	// the game paces itself by the scroll speed it was recorded at
+	replay_saved_speed = settings.speed;
+	settings.speed = replay_hdr.speed;
+	replay_speed = speed;
+	replay_pos = 0;
+	replay_skipped = 0;
+	replay_taken_over = false;
+	replay_start = k_uptime_get_32();
+	replay_mode = REPLAY_PLAYING;
+	return 0;
+}
+
+bool replay_play_stop()
+{
+	if (replay_mode == REPLAY_PLAYING) {
+		replay_mode = REPLAY_OFF;
+		printk("[%s] %u ms, %u of %u events\n", __func__,
+			k_uptime_get_32() - replay_start, replay_pos, replay_hdr.n_events);
+	}
+	// also after a take-over, which played on at the recorded speed
+	if (replay_saved_speed) {
+		settings.speed = replay_saved_speed;
+		replay_saved_speed = 0;
+	}
+	return replay_taken_over;
+}
+
+bool replay_full_speed()
+{
+	return replay_mode == REPLAY_PLAYING && replay_speed == REPLAY_FULL_SPEED;
+}
+
+void replay_take_over()
+{
+	replay_mode = REPLAY_OFF;
+	replay_taken_over = true;
+	printk("[%s] after %u of %u events\n", __func__, replay_pos, replay_hdr.n_events);
+}
+
+int replay_next(uint32_t mask, k_timeout_t timeout,
+	struct buttons_event_t *evt, k_timeout_t *wait)
+{
+	if (replay_mode != REPLAY_PLAYING)
+		return -1;
+
+	*wait = (replay_speed == REPLAY_REALTIME) ? timeout : K_NO_WAIT;
+	while (replay_pos < replay_hdr.n_events) {
+		const struct replay_event_t *r = replay_load(replay_pos);
+		if ( ! r)
+			break;
+		if (replay_skipped < replay_skips(r)) {
+			++replay_skipped;
+			return 0; // timed out
+		}
+		++replay_pos;
+		replay_skipped = 0;
+		if (r->event != REPLAY_FILLER) {
+			replay_decode(r->event, evt);
+			*wait = K_NO_WAIT; // read at once, when recorded
+			return (buttons_event_mask(evt) & mask) != 0;
+		}
+	}
+	return 0; // past the end, all reads time out
+}
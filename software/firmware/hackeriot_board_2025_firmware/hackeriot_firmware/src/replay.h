@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2025 Benny Meisels <benny.meisels@gmail.com>
+ *                    Rani Hod <rani.hod@gmail.com>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef __REPLAY_H__
+#define __REPLAY_H__
+
+#include <zephyr/kernel.h>
+
+#include "buttons.h"
+#include "persist.h"
+
+// Deterministic record and replay of a game. A game draws all its
+// randomness from replay_rand*(), seeded per run, and reads all input
+// through buttons_get*(); the recording is the seed and, for every input
+// read, whether it timed out or which event it returned. Games read once
+// per tick without waiting (see game.h), so no wait times are kept: the
+// tick deadlines pace a replay. Some games tick at the scroll speed, so
+// a run keeps settings.speed too, and replaying sets it for the game.
+// Replaying feeds the same answers back, so the game runs the same.
+//
+// Each finished run is summed up on the console, and dumped in full with
+// -DREPLAY_BENCHMARK=ON; the best complete run per game is kept in the
+// EEPROM for replays. Records go to the EEPROM a page at a time while
+// recording and playing, so a run can be longer than RAM allows.
+
+#define REPLAY_MAGIC        0x34505248UL /* 'HRP4', with the speed */
+#define REPLAY_HEADER_SIZE  16
+#define REPLAY_EVENT_SIZE   2
+#define REPLAY_MAX_EVENTS   ((EEPROM_REPLAY_SLOT - REPLAY_HEADER_SIZE) / REPLAY_EVENT_SIZE)
+
+enum replay_speed {
+    REPLAY_REALTIME = 0,    // input waits as the game asks; a press takes over
+    REPLAY_FULL_SPEED,      // input waits skipped, for benchmarks
+};
+
+uint32_t replay_rand32();
+static inline uint8_t replay_rand8() { return replay_rand32() >> 24; }
+
+void replay_record_start(const struct device *eeprom, uint8_t game);
+void replay_record_stop(const struct device *eeprom, unsigned score);
+
+int replay_play_start(const struct device *eeprom, uint8_t game,
+    enum replay_speed speed);
+bool replay_play_stop(); // true if the player took over
+bool replay_full_speed(); // replaying at REPLAY_FULL_SPEED: skip all waits
+
+// for buttons_get_event(): while replaying, the answer for one input read
+// (-1 when not replaying) and how long to take over it
+int replay_next(uint32_t mask, k_timeout_t timeout,
+    struct buttons_event_t *evt, k_timeout_t *wait);
+void replay_take_over();
+void replay_record(const struct buttons_event_t *evt);
+
+#endif // __REPLAY_H__
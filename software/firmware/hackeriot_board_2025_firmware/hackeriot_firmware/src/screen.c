@@ -7,29 +7,268 @@
 
 
 #include <zephyr/kernel.h>
+#include <zephyr/drivers/i2c.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/barrier.h>
 #include <zephyr/sys/printk.h>
 
+#include "bitboard.h"
 #include "buttons.h"
+#include "fontpack.h"
+#include "latency.h"
+#include "layout.h"
 #include "led.h"
 #include "screen.h"
+#include "stats.h"
 #include "persist.h"
 
-#define H_MASK 0x0101010101010101ULL
-#define UTF8_HEBREW_MSB 0xd7
 
-#ifdef BREADBOARD
+// HT16K33 display RAM: 8 rows (COM0-7) of 16 bits, i.e. 2 bytes per row;
+// only the low byte (ROW0-7) of each row is wired to the matrix.
+#define HT16K33_CMD_DISP_DATA_ADDR  0x00
+#define HT16K33_DISP_ROWS           8
+
+// Bitmaps are mapped to display RAM with whole-word transforms: a
+// transpose, then flipping rows and/or columns. Afterwards, bitmap byte k
+// is the k-th display RAM row and bit j of a byte is ROW j.
+#define XFORM_TRANSPOSE     BIT(0)
+#define XFORM_FLIP_ROWS     BIT(1)
+#define XFORM_FLIP_COLUMNS  BIT(2)
+
+#ifdef CONFIG_BOARD_HACKERIOT_BOARD_2025_BREADBOARD
 	// Adafruit's dual-colored HT16K33
-	#define POS_TO_LED(x) ((x&7) | ((x&~7) << 1))
+	#define XFORM_BOARD 0
 #else
 	// board2025 monochromatic HT16K33, rotated
-	#define POS_TO_LED(x) (((63-x)&7) | (((63-x)&~7) << 1))
+	#define XFORM_BOARD (XFORM_FLIP_ROWS | XFORM_FLIP_COLUMNS)
 #endif
 
-static struct screen_data_t {
+// enum screen_orientation to transform; flips commute, so composing with
+// XFORM_BOARD is an xor
+static const uint8_t orientation_xform[SCREEN_ORIENT_END] = {
+    [SCREEN_ORIENT_0]                       = 0,
+    [SCREEN_ORIENT_90]                      = XFORM_TRANSPOSE | XFORM_FLIP_COLUMNS,
+    [SCREEN_ORIENT_180]                     = XFORM_FLIP_ROWS | XFORM_FLIP_COLUMNS,
+    [SCREEN_ORIENT_270]                     = XFORM_TRANSPOSE | XFORM_FLIP_ROWS,
+    [SCREEN_ORIENT_MIRROR]                  = XFORM_FLIP_COLUMNS,
+    [SCREEN_ORIENT_MIRROR | SCREEN_ORIENT_90]  = XFORM_TRANSPOSE,
+    [SCREEN_ORIENT_MIRROR | SCREEN_ORIENT_180] = XFORM_FLIP_ROWS,
+    [SCREEN_ORIENT_MIRROR | SCREEN_ORIENT_270] = XFORM_TRANSPOSE | XFORM_FLIP_ROWS | XFORM_FLIP_COLUMNS,
+};
+
+static uint8_t screen_xform = XFORM_BOARD;
+
+struct screen_data_t {
     uint64_t bitmap;
     uint64_t blink_fast_mask;
     uint64_t blink_slow_mask;
-} screen_data;
+#if SCREEN_GRAY_BITS
+    uint64_t gray_mask;                 // pixels shown from the gray planes
+    uint64_t gray[SCREEN_GRAY_BITS];    // gray[k] is bit k of each level
+#endif
+};
+
+// Frame state is double-buffered: mutators edit screen_draft under a
+// spinlock (cheap on the single-core M0+, and usable from input callbacks),
+// then publish it to screen_data. The screen thread reads screen_data
+// without locking, retrying if screen_seq shows a publish in progress.
+static struct k_spinlock screen_lock;   // serializes writers
+static struct screen_data_t screen_draft;
+static struct screen_data_t screen_data; // published frame
+static atomic_t screen_seq;             // odd while screen_data is written
+static unsigned screen_batch;           // screen_begin() nesting depth
+
+// given on every publish; the screen thread otherwise sleeps until the
+// next blink phase, or forever if nothing blinks
+static K_SEM_DEFINE(screen_wake, 0, 1);
+
+// display pipeline counters, reset after screen_print_stats() by the
+// thread that writes them
+static struct screen_stats_t {
+    // written by the screen thread only
+    struct stats_hist_t frame_us;   // work per frame, including I2C
+    struct stats_hist_t late_us;    // publish or blink deadline to flushed
+    struct stats_hist_t pixels;     // pixels changed per frame
+    struct stats_hist_t flush_us;   // I2C time per frame flush
+#if SCREEN_GRAY_BITS
+    struct stats_hist_t subframe_us; // I2C time per gray subframe flush
+    uint32_t gray_cycles;           // modulation cycles, not counted as frames
+#endif
+    uint32_t misses;                // frames flushed over a frame period late
+    uint32_t dropped;               // published frames never shown
+    uint32_t flushes;               // number of flushes that hit the bus
+    uint32_t pixel_bytes;   // bytes the per-pixel led_on/led_off path would send
+    uint32_t burst_bytes;   // bytes actually sent by burst flushes
+    // written by swipes (UI thread) only
+    struct stats_hist_t step_over_us; // actual minus requested pixel delay
+    uint64_t step_requested_us;
+    uint64_t step_actual_us;
+} screen_stats = {
+    .frame_us = STATS_HIST_INIT(6),
+    .late_us = STATS_HIST_INIT(8),
+    .pixels = STATS_HIST_INIT(0),
+    .flush_us = STATS_HIST_INIT(6),
+#if SCREEN_GRAY_BITS
+    .subframe_us = STATS_HIST_INIT(6),
+#endif
+    .step_over_us = STATS_HIST_INIT(6),
+};
+static atomic_t screen_stats_reset;     // set by screen_print_stats()
+static uint32_t screen_publish_cycles; // when screen_data was last published
+
+static inline uint64_t screen_to_ram(uint64_t x, uint8_t xform)
+{
+    if (xform & XFORM_TRANSPOSE)
+        x = bb_transpose(x);
+    if (xform & XFORM_FLIP_ROWS)
+        x = bb_flip_vertical(x);
+    if (xform & XFORM_FLIP_COLUMNS)
+        x = bb_flip_horizontal(x);
+    return x;
+}
+
+// take a consistent snapshot of the published frame; returns its sequence
+static atomic_val_t screen_read(struct screen_data_t *frame)
+{
+    atomic_val_t seq;
+    do {
+        seq = atomic_get(&screen_seq);
+        barrier_dmem_fence_full();
+        *frame = screen_data;
+        barrier_dmem_fence_full();
+    } while ((seq & 1) || seq != atomic_get(&screen_seq));
+    return seq;
+}
+
+// publish the draft unless inside a batch, then release the writer lock
+static void screen_unlock(k_spinlock_key_t key)
+{
+    bool publish = ! screen_batch;
+    if (publish) {
+        atomic_inc(&screen_seq);
+        barrier_dmem_fence_full();
+        screen_data = screen_draft;
+        barrier_dmem_fence_full();
+        atomic_inc(&screen_seq);
+        screen_publish_cycles = k_cycle_get_32();
+        latency_publish(atomic_get(&screen_seq));
+    }
+    k_spin_unlock(&screen_lock, key);
+    if (publish)
+        k_sem_give(&screen_wake);
+}
+
+// write the dirty row span of the display RAM in a single I2C transaction,
+// timing it into flush_us; returns false if the display RAM is still stale
+static bool screen_flush(const struct i2c_dt_spec *i2c, uint64_t bitmap,
+    struct stats_hist_t *flush_us)
+{
+    static uint64_t shown = 0; // display RAM contents, all blank after init
+
+    uint64_t ram = screen_to_ram(bitmap, screen_xform);
+    uint64_t dirty = ram ^ shown;
+    if ( ! dirty)
+        return true;
+
+    unsigned first = __builtin_ctzll(dirty) / 8;
+    unsigned last = (63 - __builtin_clzll(dirty)) / 8;
+
+    // rows first..last, interleaved with the unused high bytes
+    uint8_t buf[2 * HT16K33_DISP_ROWS - 1] = {0};
+    unsigned len = 2 * (last - first) + 1;
+    for (unsigned r = first; r <= last; r++)
+        buf[2 * (r - first)] = ram >> (8 * r);
+
+    uint32_t start = k_cycle_get_32();
+    int rc = i2c_burst_write_dt(i2c, HT16K33_CMD_DISP_DATA_ADDR + 2 * first, buf, len);
+    stats_hist_add(flush_us, k_cyc_to_us_ceil32(k_cycle_get_32() - start));
+    if (rc < 0) {
+        printk("[%s] write error; code=%d\n", __func__, rc);
+        return false; // keep dirty, retry next frame
+    }
+    shown = ram;
+
+    // each led_on/led_off is a 2-byte write (address, data)
+    ++screen_stats.flushes;
+    screen_stats.pixel_bytes += 2 * __builtin_popcountll(dirty);
+    screen_stats.burst_bytes += 1 + len;
+    return true;
+}
+
+// start a new period of the screen thread's counters; screen thread only
+static void screen_stats_restart()
+{
+    struct screen_stats_t *st = &screen_stats;
+    st->misses = st->dropped = 0;
+    st->flushes = st->pixel_bytes = st->burst_bytes = 0;
+    stats_hist_reset(&st->frame_us);
+    stats_hist_reset(&st->late_us);
+    stats_hist_reset(&st->pixels);
+    stats_hist_reset(&st->flush_us);
+#if SCREEN_GRAY_BITS
+    st->gray_cycles = 0;
+    stats_hist_reset(&st->subframe_us);
+#endif
+}
+
+void screen_print_stats()
+{
+    struct screen_stats_t *st = &screen_stats;
+    unsigned flushes = st->flushes ? st->flushes : 1;
+    printk("screen: %u flushes, I2C bytes/flush %u per-pixel -> %u burst\n",
+        st->flushes, st->pixel_bytes / flushes, st->burst_bytes / flushes);
+    printk("screen: %u deadline misses, %u frames dropped\n",
+        st->misses, st->dropped);
+    stats_hist_print("frame us", &st->frame_us);
+    stats_hist_print("late us", &st->late_us);
+    stats_hist_print("pixels/frame", &st->pixels);
+    stats_hist_print("flush us", &st->flush_us);
+    printk("swipe: pixel delay requested %u ms, actual %u ms\n",
+        (uint32_t)(st->step_requested_us / 1000), (uint32_t)(st->step_actual_us / 1000));
+    stats_hist_print("step over us", &st->step_over_us);
+#if SCREEN_GRAY_BITS
+    // the shortest subframe lasts one time unit, and its flush must fit in it
+    printk("screen: %u gray cycles\n", st->gray_cycles);
+    stats_hist_print("subframe flush us", &st->subframe_us);
+    uint32_t us = MAX(st->flush_us.max, st->subframe_us.max);
+    const uint32_t unit_us = 1000000 / (SCREEN_GRAY_HZ * SCREEN_GRAY_MAX);
+    if (us) {
+        printk("screen: slowest flush %u us, max %u gray subframes/s "
+            "(need %u)\n", us, 1000000 / us, SCREEN_GRAY_HZ * SCREEN_GRAY_MAX);
+        if (us > unit_us)
+            printk("screen: WARNING flush takes longer than a %u us gray subframe\n",
+                unit_us);
+    }
+#endif
+
+    // start a new period; the swipe counters are this thread's, the
+    // others are reset by the screen thread when it wakes
+    st->step_requested_us = st->step_actual_us = 0;
+    stats_hist_reset(&st->step_over_us);
+    atomic_set(&screen_stats_reset, 1);
+    k_sem_give(&screen_wake);
+}
+
+#if SCREEN_GRAY_BITS
+// Binary code modulation: show plane k for 2^k time units, so each pixel
+// is lit for a fraction of the cycle proportional to its level. Blocks
+// for one full cycle; planes identical to the previous one cost no I2C.
+static bool screen_render_gray(const struct i2c_dt_spec *i2c,
+    const struct screen_data_t *frame, uint64_t current)
+{
+    const k_ticks_t unit = k_us_to_ticks_ceil32(
+        1000000 / (SCREEN_GRAY_HZ * SCREEN_GRAY_MAX));
+    uint64_t solid = current & ~frame->gray_mask;
+    k_ticks_t t = k_uptime_ticks();
+    bool flushed = true;
+    for (unsigned k = 0; k < SCREEN_GRAY_BITS; k++) {
+        flushed &= screen_flush(i2c, solid | frame->gray[k], &screen_stats.subframe_us);
+        t += unit << k;
+        k_sleep(K_TIMEOUT_ABS_TICKS(t));
+    }
+    return flushed;
+}
+#endif
 
 static void screen_thread_func(void *, void *, void *)
 {
@@ -38,38 +277,97 @@ static void screen_thread_func(void *, void *, void *)
 		printk("[%s] LED device not ready\n", __func__);
 		return;
 	}
+    // the LED driver owns init, blink and dimming; pixels go straight to RAM
+    static const struct i2c_dt_spec i2c = I2C_DT_SPEC_GET(LED_NODE);
+
+    // all timing is on absolute tick boundaries, so work done per frame
+    // does not make the frame rate or the blink phases drift
+    const k_ticks_t frame_ticks = k_ms_to_ticks_ceil32(1000 / SCREEN_FPS);
+    const k_ticks_t fast_ticks = k_ms_to_ticks_ceil32(1000 / SCREEN_BLINK_FAST);
+    const k_ticks_t slow_ticks = k_ms_to_ticks_ceil32(1000 / SCREEN_BLINK_SLOW);
 
-    uint32_t tick = 0;
     static uint64_t current = 0; // all blank
+    struct screen_data_t frame;
+    k_ticks_t frame_start = 0;
+    int64_t fast_phase = 0, slow_phase = 0;
+    k_timeout_t timeout = K_FOREVER;
+    k_ticks_t deadline = INT64_MAX;
+    atomic_val_t seq, last_seq = 0;
+    bool gray = false;
     while(1) {
-        // calculate LEDs to invert [TODO: mutex]
-        uint64_t inv_mask = current ^ screen_data.bitmap;
-        inv_mask &= ~(screen_data.blink_fast_mask | screen_data.blink_slow_mask);
-        if (tick % (SCREEN_FPS/SCREEN_BLINK_FAST) == 0)
-            inv_mask |= screen_data.blink_fast_mask;
-        if (tick % (SCREEN_FPS/SCREEN_BLINK_SLOW) == 0)
-            inv_mask |= screen_data.blink_slow_mask;
-
-        if (inv_mask) {
-            // invert LEDs
-            for (unsigned j = 0; j < 64; j++) {
-                if ((inv_mask >> j) & 1) {
-                    unsigned pos = POS_TO_LED(j);
-                    if ((current >> j) & 1)
-                        led_off(led, pos);
-                    else
-                        led_on(led, pos);
-                }
-            }
-            // update current LED bitmap
-            current ^= inv_mask;
+        // sleep until the next publish or blink deadline, then hold
+        // off until the next frame slot to coalesce bursts of publishes
+        // (grayscale cycles pace themselves)
+        k_sem_take(&screen_wake, timeout);
+        if (atomic_cas(&screen_stats_reset, 1, 0))
+            screen_stats_restart();
+        if ( ! gray)
+            k_sleep(K_TIMEOUT_ABS_TICKS(frame_start + frame_ticks));
+        frame_start = k_uptime_ticks();
+        uint32_t start = k_cycle_get_32();
+
+        // calculate LEDs to invert
+        seq = screen_read(&frame);
+        uint64_t inv_mask = current ^ frame.bitmap;
+        inv_mask &= ~(frame.blink_fast_mask | frame.blink_slow_mask);
+        if (frame_start / fast_ticks != fast_phase) {
+            fast_phase = frame_start / fast_ticks;
+            inv_mask |= frame.blink_fast_mask;
+        }
+        if (frame_start / slow_ticks != slow_phase) {
+            slow_phase = frame_start / slow_ticks;
+            inv_mask |= frame.blink_slow_mask;
+        }
+
+        // update current LED bitmap and push it to the display
+        current ^= inv_mask;
+        bool flushed;
+#if SCREEN_GRAY_BITS
+        gray = frame.gray_mask != 0;
+        if (gray)
+            flushed = screen_render_gray(&i2c, &frame, current);
+        else
+#endif
+        flushed = screen_flush(&i2c, current, &screen_stats.flush_us);
+        if (flushed)
+            latency_visible(seq);
+        //printk("(%lld) inv_mask=%016llx current=%016llx\n", frame_start, inv_mask, current);
 
+        // instrumentation: lateness is measured from the newest publish,
+        // or from the blink deadline we were waiting for
+        uint32_t end = k_cycle_get_32();
+        uint32_t late_us = 0;
+        bool published = (seq != last_seq);
+        if (published) {
+            late_us = k_cyc_to_us_floor32(end - screen_publish_cycles);
+            screen_stats.dropped += (seq - last_seq) / 2 - 1;
+            last_seq = seq;
+        } else if (deadline != INT64_MAX && frame_start > deadline)
+            late_us = k_ticks_to_us_floor32(frame_start - deadline);
+#if SCREEN_GRAY_BITS
+        if (gray)
+            ++screen_stats.gray_cycles; // a full cycle, not a frame
+        else
+#endif
+        if (inv_mask || published) {
+            stats_hist_add(&screen_stats.frame_us, k_cyc_to_us_ceil32(end - start));
+            stats_hist_add(&screen_stats.late_us, late_us);
+            stats_hist_add(&screen_stats.pixels, __builtin_popcountll(inv_mask));
+            if (late_us > 1000000 / SCREEN_FPS)
+                ++screen_stats.misses;
         }
-        //printk("(%d) inv_mask=%016llx current=%016llx\n", tick, inv_mask, current);
 
-        // sleep until next tick
-        ++tick;
-        k_msleep(1000 / SCREEN_FPS);
+        // compute the next deadline
+        deadline = INT64_MAX;
+        if (frame.blink_fast_mask)
+            deadline = MIN(deadline, (fast_phase + 1) * fast_ticks);
+        if (frame.blink_slow_mask)
+            deadline = MIN(deadline, (slow_phase + 1) * slow_ticks);
+        if ( ! flushed)
+            deadline = frame_start + frame_ticks;
+        timeout = (deadline == INT64_MAX) ? K_FOREVER : K_TIMEOUT_ABS_TICKS(deadline);
+        if (gray)
+            timeout = K_NO_WAIT;
     }
 }
 
@@ -80,6 +378,12 @@ K_THREAD_DEFINE(
     10, 0, 1);          // prio, options, delay
 
 
+void screen_set_orientation(enum screen_orientation orientation)
+{
+    screen_xform = orientation_xform[orientation % SCREEN_ORIENT_END] ^ XFORM_BOARD;
+    k_sem_give(&screen_wake); // redraw
+}
+
 // blinkall functions
 void screen_blinkall(enum blink_speed bs)
 {
@@ -88,228 +392,525 @@ void screen_blinkall(enum blink_speed bs)
 }
 
 // glyph constants and functions
-static const uint64_t glyph_printable_ascii[] = {
-	0x183C3C1818001800,	// Char 033 (!)
-	0x6C6C6C0000000000,	// Char 034 (")
-	0x6C6CFE6CFE6C6C00,	// Char 035 (#)
-	0x183E603C067C1800,	// Char 036 ($)
-	0x00C6CC183066C600,	// Char 037 (%)
-	0x386C3876DCCC7600,	// Char 038 (&)
-	0x3030600000000000,	// Char 039 (')
-	0x0C18303030180C00,	// Char 040 (()
-	0x30180C0C0C183000,	// Char 041 ())
-	0x00663CFF3C660000,	// Char 042 (*)
-	0x0018187E18180000,	// Char 043 (+)
-	0x0000000000181830,	// Char 044 (,)
-	0x0000007E00000000,	// Char 045 (-)
-	0x0000000000181800,	// Char 046 (.)
-	0x060C183060C08000,	// Char 047 (/)
-	0x386CC6D6C66C3800,	// Char 048 (0)
-	0x1838181818187E00,	// Char 049 (1)
-	0x3C66061C30667E00,	// Char 050 (2)
-	0x3C66061C06663C00,	// Char 051 (3)
-	0x1C3C6CCCFE0C1E00,	// Char 052 (4)
-	0x7E607C0606663C00,	// Char 053 (5)
-	0x1C30607C66663C00,	// Char 054 (6)
-	0x7E66060C18181800,	// Char 055 (7)
-	0x3C66663C66663C00,	// Char 056 (8)
-	0x3C66663E060C3800,	// Char 057 (9)
-	0x0018180000181800,	// Char 058 (:)
-	0x0018180000181830,	// Char 059 (;)
-	0x0C18306030180C00,	// Char 060 (<)
-	0x00007E00007E0000,	// Char 061 (=)
-	0x30180C060C183000,	// Char 062 (>)
-	0x3C66060C18001800,	// Char 063 (?)
-	0x7CC6DEDEDEC07800,	// Char 064 (@)
-	0x183C66667E666600,	// Char 065 (A)
-	0xFC66667C6666FC00,	// Char 066 (B)
-	0x3C66C0C0C0663C00,	// Char 067 (C)
-	0xF86C6666666CF800,	// Char 068 (D)
-	0xFE6268786862FE00,	// Char 069 (E)
-	0xFE6268786860F000,	// Char 070 (F)
-	0x3C66C0C0CE663E00,	// Char 071 (G)
-	0x6666667E66666600,	// Char 072 (H)
-	0x3C18181818183C00,	// Char 073 (I)
-	0x1E0C0C0CCCCC7800,	// Char 074 (J)
-	0xE6666C786C66E600,	// Char 075 (K)
-	0xF06060606266FE00,	// Char 076 (L)
-	0xC6EEFEFED6C6C600,	// Char 077 (M)
-	0xC6E6F6DECEC6C600,	// Char 078 (N)
-	0x7CC6C6C6C6C67C00,	// Char 079 (O)
-	0xFC66667C6060F000,	// Char 080 (P)
-	0x7CC6C6C6C6CE7C0E,	// Char 081 (Q)
-	0xFC66667C6C66E600,	// Char 082 (R)
-	0x3C6670380E663C00,	// Char 083 (S)
-	0x7E5A181818183C00,	// Char 084 (T)
-	0x6666666666667E00,	// Char 085 (U)
-	0x66666666663C1800,	// Char 086 (V)
-	0xC6C6C6D6FEEEC600,	// Char 087 (W)
-	0xC6C66C38386CC600,	// Char 088 (X)
-	0x6666663C18183C00,	// Char 089 (Y)
-	0xFEC68C183266FE00,	// Char 090 (Z)
-	0x3C30303030303C00,	// Char 091 ([)
-	0xC06030180C060200,	// Char 092 (\)
-	0x3C0C0C0C0C0C3C00,	// Char 093 (])
-	0x10386CC600000000,	// Char 094 (^)
-	0x00000000000000FF,	// Char 095 (_)
-	0x3030180000000000,	// Char 096 (`)
-	0x0000780C7CCC7600,	// Char 097 (a)
-	0xE060607C6666DC00,	// Char 098 (b)
-	0x00003C6660663C00,	// Char 099 (c)
-	0x1C0C0C7CCCCC7600,	// Char 100 (d)
-	0x00003C667E603C00,	// Char 101 (e)
-	0x1C36307830307800,	// Char 102 (f)
-	0x000076CCCC7C0CF8,	// Char 103 (g)
-	0xE0606C766666E600,	// Char 104 (h)
-	0x1800381818183C00,	// Char 105 (i)
-	0x060006060666663C,	// Char 106 (j)
-	0xE060666C786CE600,	// Char 107 (k)
-	0x3818181818183C00,	// Char 108 (l)
-	0x0000CCFEFED6C600,	// Char 109 (m)
-	0x0000DC6666666600,	// Char 110 (n)
-	0x00003C6666663C00,	// Char 111 (o)
-	0x0000DC66667C60F0,	// Char 112 (p)
-	0x000076CCCC7C0C1E,	// Char 113 (q)
-	0x0000DC766660F000,	// Char 114 (r)
-	0x00003E603C067C00,	// Char 115 (s)
-	0x10307C3030341800,	// Char 116 (t)
-	0x0000CCCCCCCC7600,	// Char 117 (u)
-	0x00006666663C1800,	// Char 118 (v)
-	0x0000C6D6FEFE6C00,	// Char 119 (w)
-	0x0000C66C386CC600,	// Char 120 (x)
-	0x00006666663E067C,	// Char 121 (y)
-	0x00007E4C18327E00,	// Char 122 (z)
-	0x0E18187018180E00,	// Char 123 ({)
-	0x1818180018181800,	// Char 124 (|)
-	0x7018180E18187000,	// Char 125 (})
-	0x76DC000000000000,	// Char 126 (~)
+
+// Proportional font, stored column-major: glyph i is columns
+// font_columns[font_index[i]] .. font_columns[font_index[i+1] - 1], left
+// to right, with bit r of a column being row r (bit 0 = bottom row).
+// Glyph 0 is space, then printable ASCII, then Hebrew, then "unknown".
+#define GLYPH_ASCII     1
+#define GLYPH_HEBREW    (GLYPH_ASCII + '~' - ' ')
+#define GLYPH_UNKNOWN   (GLYPH_HEBREW + 27)
+#define GLYPH_GAP       1   // blank columns between glyphs
+
+static const uint16_t font_index[] = {
+	0, 2, 6, 11, 18, 24, 31, 38, 41, 45, 49, 57,
+	63, 66, 72, 74, 81, 88, 94, 100, 106, 113, 119, 125,
+	131, 137, 143, 145, 148, 153, 159, 164, 170, 177, 183, 190,
+	197, 204, 211, 218, 225, 231, 235, 242, 249, 256, 263, 270,
+	277, 284, 291, 298, 304, 310, 316, 322, 329, 336, 342, 349,
+	353, 360, 364, 371, 379, 382, 389, 396, 402, 409, 415, 421,
+	428, 435, 439, 445, 452, 456, 463, 470, 476, 483, 490, 497,
+	503, 508, 515, 521, 528, 535, 541, 547, 553, 555, 561, 568,
+	575, 582, 589, 596, 603, 607, 611, 618, 625, 629, 636, 643,
+	650, 657, 664, 668, 673, 680, 687, 694, 701, 707, 713, 720,
+	727, 734, 741, 749,
 };
 
-static const uint64_t glyph_hebrew[] = {
-	0x00C66676DCCCC600UL,	// Char 128 (א)
-	0x00F80C0C0C0CFE00UL,	// Char 129 (ב)
-	0x00380C0C1C34E600UL,	// Char 130 (ג)
-	0x00FE0C0C0C0C0C00UL,	// Char 131 (ד)
-	0x00FC0606C6C6C600UL,	// Char 132 (ה)
-	0x0070181818181800UL,	// Char 133 (ו)
-	0x003C18180C183000UL,	// Char 134 (ז)
-	0x00FC66C6C6C6C600UL,	// Char 135 (ח)
-	0x00CCD6D6C6CC7800UL,	// Char 136 (ט)
-	0x00380C0C18000000UL,	// Char 137 (י)
-	0x00FC06060C0C0C0EUL,	// Char 138 (ך)
-	0x00FC06060606FC00UL,	// Char 139 (כ)
-	0xC0FC06060C181800UL,	// Char 140 (ל)
-	0x00FC66C6C6C6FE00UL,	// Char 141 (ם)
-	0x00DC7666C6C6DE00UL,	// Char 142 (מ)
-	0x00380C181818181CUL,	// Char 143 (ן)
-	0x00380C0C0C0C7C00UL,	// Char 144 (נ)
-	0x00FC66C6C6CC7800UL,	// Char 145 (ס)
-	0x006666666636FC00UL,	// Char 146 (ע)
-	0x00F84CCCEC0C0C0EUL,	// Char 147 (ף)
-	0x00FC46C6E606FE00UL,	// Char 148 (פ)
-	0x006666667C606070UL,	// Char 149 (ץ)
-	0x0066361C0C067E00UL,	// Char 150 (צ)
-	0x00FC06666C6E6060UL,	// Char 151 (ק)
-	0x00FC060606060600UL,	// Char 152 (ר)
-	0x00D6D6D6F6C67C00UL,	// Char 153 (ש)
-	0x00FC666666E6E600UL,	// Char 154 (ת)
+static const uint8_t font_columns[] = {
+	0x00, 0x00,                               	// Char 032 ( )
+	0x60, 0xFA, 0xFA, 0x60,                   	// Char 033 (!)
+	0xE0, 0xE0, 0x00, 0xE0, 0xE0,             	// Char 034 (")
+	0x28, 0xFE, 0xFE, 0x28, 0xFE, 0xFE, 0x28, 	// Char 035 (#)
+	0x24, 0x74, 0xD6, 0xD6, 0x5C, 0x48,       	// Char 036 ($)
+	0x62, 0x66, 0x0C, 0x18, 0x30, 0x66, 0x46, 	// Char 037 (%)
+	0x0C, 0x5E, 0xF2, 0xBA, 0xEC, 0x5E, 0x12, 	// Char 038 (&)
+	0x20, 0xE0, 0xC0,                         	// Char 039 (')
+	0x38, 0x7C, 0xC6, 0x82,                   	// Char 040 (()
+	0x82, 0xC6, 0x7C, 0x38,                   	// Char 041 ()
+	0x10, 0x54, 0x7C, 0x38, 0x38, 0x7C, 0x54, 0x10,	// Char 042 (*)
+	0x10, 0x10, 0x7C, 0x7C, 0x10, 0x10,       	// Char 043 (+)
+	0x01, 0x07, 0x06,                         	// Char 044 (,)
+	0x10, 0x10, 0x10, 0x10, 0x10, 0x10,       	// Char 045 (-)
+	0x06, 0x06,                               	// Char 046 (.)
+	0x06, 0x0C, 0x18, 0x30, 0x60, 0xC0, 0x80, 	// Char 047 (/)
+	0x38, 0x7C, 0xC6, 0x92, 0xC6, 0x7C, 0x38, 	// Char 048 (0)
+	0x02, 0x42, 0xFE, 0xFE, 0x02, 0x02,       	// Char 049 (1)
+	0x46, 0xCE, 0x9A, 0x92, 0xF6, 0x66,       	// Char 050 (2)
+	0x44, 0xC6, 0x92, 0x92, 0xFE, 0x6C,       	// Char 051 (3)
+	0x18, 0x38, 0x68, 0xCA, 0xFE, 0xFE, 0x0A, 	// Char 052 (4)
+	0xE4, 0xE6, 0xA2, 0xA2, 0xBE, 0x9C,       	// Char 053 (5)
+	0x3C, 0x7E, 0xD2, 0x92, 0x9E, 0x0C,       	// Char 054 (6)
+	0xC0, 0xC0, 0x8E, 0x9E, 0xF0, 0xE0,       	// Char 055 (7)
+	0x6C, 0xFE, 0x92, 0x92, 0xFE, 0x6C,       	// Char 056 (8)
+	0x60, 0xF2, 0x92, 0x96, 0xFC, 0x78,       	// Char 057 (9)
+	0x66, 0x66,                               	// Char 058 (:)
+	0x01, 0x67, 0x66,                         	// Char 059 (;)
+	0x10, 0x38, 0x6C, 0xC6, 0x82,             	// Char 060 (<)
+	0x24, 0x24, 0x24, 0x24, 0x24, 0x24,       	// Char 061 (=)
+	0x82, 0xC6, 0x6C, 0x38, 0x10,             	// Char 062 (>)
+	0x40, 0xC0, 0x8A, 0x9A, 0xF0, 0x60,       	// Char 063 (?)
+	0x7C, 0xFE, 0x82, 0xBA, 0xBA, 0xF8, 0x78, 	// Char 064 (@)
+	0x3E, 0x7E, 0xC8, 0xC8, 0x7E, 0x3E,       	// Char 065 (A)
+	0x82, 0xFE, 0xFE, 0x92, 0x92, 0xFE, 0x6C, 	// Char 066 (B)
+	0x38, 0x7C, 0xC6, 0x82, 0x82, 0xC6, 0x44, 	// Char 067 (C)
+	0x82, 0xFE, 0xFE, 0x82, 0xC6, 0x7C, 0x38, 	// Char 068 (D)
+	0x82, 0xFE, 0xFE, 0x92, 0xBA, 0x82, 0xC6, 	// Char 069 (E)
+	0x82, 0xFE, 0xFE, 0x92, 0xB8, 0x80, 0xC0, 	// Char 070 (F)
+	0x38, 0x7C, 0xC6, 0x82, 0x8A, 0xCE, 0x4E, 	// Char 071 (G)
+	0xFE, 0xFE, 0x10, 0x10, 0xFE, 0xFE,       	// Char 072 (H)
+	0x82, 0xFE, 0xFE, 0x82,                   	// Char 073 (I)
+	0x0C, 0x0E, 0x02, 0x82, 0xFE, 0xFC, 0x80, 	// Char 074 (J)
+	0x82, 0xFE, 0xFE, 0x10, 0x38, 0xEE, 0xC6, 	// Char 075 (K)
+	0x82, 0xFE, 0xFE, 0x82, 0x02, 0x06, 0x0E, 	// Char 076 (L)
+	0xFE, 0xFE, 0x70, 0x38, 0x70, 0xFE, 0xFE, 	// Char 077 (M)
+	0xFE, 0xFE, 0x60, 0x30, 0x18, 0xFE, 0xFE, 	// Char 078 (N)
+	0x7C, 0xFE, 0x82, 0x82, 0x82, 0xFE, 0x7C, 	// Char 079 (O)
+	0x82, 0xFE, 0xFE, 0x92, 0x90, 0xF0, 0x60, 	// Char 080 (P)
+	0x7C, 0xFE, 0x82, 0x82, 0x87, 0xFF, 0x7D, 	// Char 081 (Q)
+	0x82, 0xFE, 0xFE, 0x90, 0x98, 0xFE, 0x66, 	// Char 082 (R)
+	0x64, 0xF6, 0xB2, 0x9A, 0xCE, 0x4C,       	// Char 083 (S)
+	0xC0, 0x82, 0xFE, 0xFE, 0x82, 0xC0,       	// Char 084 (T)
+	0xFE, 0xFE, 0x02, 0x02, 0xFE, 0xFE,       	// Char 085 (U)
+	0xF8, 0xFC, 0x06, 0x06, 0xFC, 0xF8,       	// Char 086 (V)
+	0xFE, 0xFE, 0x0C, 0x18, 0x0C, 0xFE, 0xFE, 	// Char 087 (W)
+	0xC2, 0xE6, 0x3C, 0x18, 0x3C, 0xE6, 0xC2, 	// Char 088 (X)
+	0xE0, 0xF2, 0x1E, 0x1E, 0xF2, 0xE0,       	// Char 089 (Y)
+	0xE2, 0xC6, 0x8E, 0x9A, 0xB2, 0xE6, 0xCE, 	// Char 090 (Z)
+	0xFE, 0xFE, 0x82, 0x82,                   	// Char 091 ([)
+	0x80, 0xC0, 0x60, 0x30, 0x18, 0x0C, 0x06, 	// Char 092 (\)
+	0x82, 0x82, 0xFE, 0xFE,                   	// Char 093 (])
+	0x10, 0x30, 0x60, 0xC0, 0x60, 0x30, 0x10, 	// Char 094 (^)
+	0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,	// Char 095 (_)
+	0xC0, 0xE0, 0x20,                         	// Char 096 (`)
+	0x04, 0x2E, 0x2A, 0x2A, 0x3C, 0x1E, 0x02, 	// Char 097 (a)
+	0x82, 0xFE, 0xFC, 0x12, 0x12, 0x1E, 0x0C, 	// Char 098 (b)
+	0x1C, 0x3E, 0x22, 0x22, 0x36, 0x14,       	// Char 099 (c)
+	0x0C, 0x1E, 0x12, 0x92, 0xFC, 0xFE, 0x02, 	// Char 100 (d)
+	0x1C, 0x3E, 0x2A, 0x2A, 0x3A, 0x18,       	// Char 101 (e)
+	0x12, 0x7E, 0xFE, 0x92, 0xC0, 0x40,       	// Char 102 (f)
+	0x19, 0x3D, 0x25, 0x25, 0x1F, 0x3E, 0x20, 	// Char 103 (g)
+	0x82, 0xFE, 0xFE, 0x10, 0x20, 0x3E, 0x1E, 	// Char 104 (h)
+	0x22, 0xBE, 0xBE, 0x02,                   	// Char 105 (i)
+	0x06, 0x07, 0x01, 0x01, 0xBF, 0xBE,       	// Char 106 (j)
+	0x82, 0xFE, 0xFE, 0x08, 0x1C, 0x36, 0x22, 	// Char 107 (k)
+	0x82, 0xFE, 0xFE, 0x02,                   	// Char 108 (l)
+	0x3E, 0x3E, 0x18, 0x1C, 0x38, 0x3E, 0x1E, 	// Char 109 (m)
+	0x20, 0x3E, 0x1E, 0x20, 0x20, 0x3E, 0x1E, 	// Char 110 (n)
+	0x1C, 0x3E, 0x22, 0x22, 0x3E, 0x1C,       	// Char 111 (o)
+	0x21, 0x3F, 0x1F, 0x25, 0x24, 0x3C, 0x18, 	// Char 112 (p)
+	0x18, 0x3C, 0x24, 0x25, 0x1F, 0x3F, 0x21, 	// Char 113 (q)
+	0x22, 0x3E, 0x1E, 0x32, 0x20, 0x38, 0x18, 	// Char 114 (r)
+	0x12, 0x3A, 0x2A, 0x2A, 0x2E, 0x24,       	// Char 115 (s)
+	0x20, 0x7C, 0xFE, 0x22, 0x24,             	// Char 116 (t)
+	0x3C, 0x3E, 0x02, 0x02, 0x3C, 0x3E, 0x02, 	// Char 117 (u)
+	0x38, 0x3C, 0x06, 0x06, 0x3C, 0x38,       	// Char 118 (v)
+	0x3C, 0x3E, 0x0E, 0x1C, 0x0E, 0x3E, 0x3C, 	// Char 119 (w)
+	0x22, 0x36, 0x1C, 0x08, 0x1C, 0x36, 0x22, 	// Char 120 (x)
+	0x39, 0x3D, 0x05, 0x05, 0x3F, 0x3E,       	// Char 121 (y)
+	0x32, 0x26, 0x2E, 0x3A, 0x32, 0x26,       	// Char 122 (z)
+	0x10, 0x10, 0x7C, 0xEE, 0x82, 0x82,       	// Char 123 ({)
+	0xEE, 0xEE,                               	// Char 124 (|)
+	0x82, 0x82, 0xEE, 0x7C, 0x10, 0x10,       	// Char 125 (})
+	0x40, 0xC0, 0x80, 0xC0, 0x40, 0xC0, 0x80, 	// Char 126 (~)
+	0x4E, 0x7E, 0x30, 0x18, 0x0C, 0x7E, 0x72, 	// Char 128 (א)
+	0x42, 0x42, 0x42, 0x42, 0x7E, 0x3E, 0x02, 	// Char 129 (ב)
+	0x02, 0x02, 0x46, 0x4C, 0x78, 0x3E, 0x02, 	// Char 130 (ג)
+	0x40, 0x40, 0x40, 0x40, 0x7E, 0x7E, 0x40, 	// Char 131 (ד)
+	0x4E, 0x4E, 0x40, 0x40, 0x40, 0x7E, 0x3E, 	// Char 132 (ה)
+	0x40, 0x40, 0x7E, 0x3E,                   	// Char 133 (ו)
+	0x42, 0x76, 0x7C, 0x48,                   	// Char 134 (ז)
+	0x5E, 0x7E, 0x60, 0x40, 0x40, 0x7E, 0x3E, 	// Char 135 (ח)
+	0x7C, 0x7E, 0x02, 0x32, 0x46, 0x7C, 0x38, 	// Char 136 (ט)
+	0x40, 0x48, 0x78, 0x30,                   	// Char 137 (י)
+	0x40, 0x40, 0x40, 0x40, 0x4F, 0x7F, 0x31, 	// Char 138 (ך)
+	0x42, 0x42, 0x42, 0x42, 0x42, 0x7E, 0x3C, 	// Char 139 (כ)
+	0xC0, 0xC0, 0x40, 0x46, 0x4E, 0x78, 0x30, 	// Char 140 (ל)
+	0x5E, 0x7E, 0x62, 0x42, 0x42, 0x7E, 0x3E, 	// Char 141 (ם)
+	0x4E, 0x7E, 0x30, 0x62, 0x42, 0x7E, 0x3E, 	// Char 142 (מ)
+	0x40, 0x5F, 0x7F, 0x21,                   	// Char 143 (ן)
+	0x02, 0x42, 0x42, 0x7E, 0x3E,             	// Char 144 (נ)
+	0x5C, 0x7E, 0x62, 0x42, 0x46, 0x7C, 0x38, 	// Char 145 (ס)
+	0x02, 0x7A, 0x7E, 0x06, 0x02, 0x7E, 0x7C, 	// Char 146 (ע)
+	0x58, 0x78, 0x48, 0x40, 0x7F, 0x3F, 0x01, 	// Char 147 (ף)
+	0x5A, 0x7A, 0x4A, 0x42, 0x42, 0x7E, 0x3E, 	// Char 148 (פ)
+	0x7F, 0x7F, 0x09, 0x08, 0x78, 0x70,       	// Char 149 (ץ)
+	0x42, 0x62, 0x32, 0x1A, 0x7E, 0x66,       	// Char 150 (צ)
+	0x40, 0x5F, 0x5F, 0x40, 0x4C, 0x7C, 0x34, 	// Char 151 (ק)
+	0x40, 0x40, 0x40, 0x40, 0x40, 0x7E, 0x3E, 	// Char 152 (ר)
+	0x7C, 0x7E, 0x0A, 0x7A, 0x02, 0x7E, 0x7C, 	// Char 153 (ש)
+	0x46, 0x7E, 0x7E, 0x40, 0x40, 0x7E, 0x3E, 	// Char 154 (ת)
+	0xAA, 0x55, 0xAA, 0x55, 0x55, 0xAA, 0x55, 0xAA,	// unknown
 };
 
-uint64_t get_glyph(char ch)
+BUILD_ASSERT(ARRAY_SIZE(font_index) == GLYPH_UNKNOWN + 2);
+
+static unsigned glyph_index(uint32_t cp)
 {
-	if (ch == ' ') 
+	if (cp == ' ')
 		return 0;
-	if (ch >= '!' && ch <= '~')
-		return glyph_printable_ascii[ch - '!'];
+	if (cp >= '!' && cp <= '~')
+		return GLYPH_ASCII + cp - '!';
+	if (cp >= 0x5d0 && cp <= 0x5ea)
+		return GLYPH_HEBREW + cp - 0x5d0;
+	return GLYPH_UNKNOWN;
+}
+
+// columns of the glyph for code point cp, built-in font first, then the
+// EEPROM font pack (into buf); *info is the width and FONTPACK_* flags
+static const uint8_t *glyph_lookup(uint32_t cp, uint8_t *info,
+	uint8_t buf[FONTPACK_GLYPH_SIZE])
+{
+	unsigned i = glyph_index(cp);
+	if (i == GLYPH_UNKNOWN && fontpack_get(cp, buf) == 0) {
+		*info = buf[0];
+		return buf + 1;
+	}
+	*info = font_index[i + 1] - font_index[i];
+	return font_columns + font_index[i];
+}
+
+// read the font pack glyphs of cps into the glyph cache ahead of time, as
+// many as it holds from the start, so that drawing them does not wait
+// for the EEPROM
+static void glyph_prefetch(const uint16_t *cps, unsigned n)
+{
+	uint8_t buf[FONTPACK_GLYPH_SIZE];
+	unsigned cached = 0;
+	for (unsigned i = 0; i < n && cached < FONTPACK_CACHE; i++) {
+		if (glyph_index(cps[i]) == GLYPH_UNKNOWN && fontpack_get(cps[i], buf) == 0)
+			++cached;
+	}
+}
+
+// spread the 8 bits of a column into the lowest bit of each row
+static inline uint64_t column_to_bitmap(uint8_t column)
+{
+	static const uint32_t nibble[16] = {
+		0x00000000, 0x00000001, 0x00000100, 0x00000101,
+		0x00010000, 0x00010001, 0x00010100, 0x00010101,
+		0x01000000, 0x01000001, 0x01000100, 0x01000101,
+		0x01010000, 0x01010001, 0x01010100, 0x01010101,
+	};
+	return nibble[column & 15] | ((uint64_t)nibble[column >> 4] << 32);
+}
+
+// centered in an 8x8 bitmap
+static uint64_t glyph_bitmap(uint32_t cp)
+{
+	uint8_t buf[FONTPACK_GLYPH_SIZE], info;
+	const uint8_t *columns = glyph_lookup(cp, &info, buf);
+	unsigned width = info & FONTPACK_WIDTH;
+	uint64_t bitmap = 0;
+	for (unsigned c = 0; c < width; c++)
+		bitmap = (bitmap << 1) | column_to_bitmap(columns[c]);
+	return bitmap << ((8 - width) / 2);
+}
+
+uint64_t get_glyph(char ch)
+{
 	uint8_t uch = ch;
-	if (uch >= 0x90 && uch <= 0xab)
-		return glyph_hebrew[uch - 0x90];
+	if (uch >= 0x90 && uch <= 0xaa) // second byte of a Hebrew letter
+		return glyph_bitmap(0x5d0 + uch - 0x90);
+	return glyph_bitmap(uch);
+}
+
+// drop pixels from the gray planes (1-bit edits override gray levels)
+static inline void screen_ungray(uint64_t mask)
+{
+#if SCREEN_GRAY_BITS
+    screen_draft.gray_mask &= ~mask;
+    for (unsigned k = 0; k < SCREEN_GRAY_BITS; k++)
+        screen_draft.gray[k] &= ~mask;
+#endif
+}
+
+// batch functions
+void screen_begin()
+{
+    k_spinlock_key_t key = k_spin_lock(&screen_lock);
+    ++screen_batch;
+    k_spin_unlock(&screen_lock, key);
+}
 
-	return 0xA55AA55AA55AA55AULL; // unknown
+void screen_commit()
+{
+    k_spinlock_key_t key = k_spin_lock(&screen_lock);
+    if (screen_batch) --screen_batch;
+    screen_unlock(key);
 }
 
 // pixel functions
 void screen_mask_on(uint64_t mask)
 {
-    // TODO: mutex
-    screen_data.bitmap |= mask;
-    screen_data.blink_fast_mask &= ~mask;
-    screen_data.blink_slow_mask &= ~mask;
+    k_spinlock_key_t key = k_spin_lock(&screen_lock);
+    screen_draft.bitmap |= mask;
+    screen_draft.blink_fast_mask &= ~mask;
+    screen_draft.blink_slow_mask &= ~mask;
+    screen_ungray(mask);
+    screen_unlock(key);
 }
 
 void screen_mask_off(uint64_t mask)
 {
-    // TODO: mutex
-    screen_data.bitmap &= ~mask;
-    screen_data.blink_fast_mask &= ~mask;
-    screen_data.blink_slow_mask &= ~mask;
+    k_spinlock_key_t key = k_spin_lock(&screen_lock);
+    screen_draft.bitmap &= ~mask;
+    screen_draft.blink_fast_mask &= ~mask;
+    screen_draft.blink_slow_mask &= ~mask;
+    screen_ungray(mask);
+    screen_unlock(key);
 }
 
 void screen_mask_invert(uint64_t mask)
 {
-    // TODO: mutex
-    screen_data.bitmap ^= mask;
-    screen_data.blink_fast_mask &= ~mask;
-    screen_data.blink_slow_mask &= ~mask;
+    k_spinlock_key_t key = k_spin_lock(&screen_lock);
+    screen_draft.bitmap ^= mask;
+    screen_draft.blink_fast_mask &= ~mask;
+    screen_draft.blink_slow_mask &= ~mask;
+    screen_ungray(mask);
+    screen_unlock(key);
 }
 
 void screen_mask_blink(uint64_t mask, bool fast)
 {
-    // TODO: mutex
-    screen_data.bitmap &= ~mask;
+    k_spinlock_key_t key = k_spin_lock(&screen_lock);
+    screen_draft.bitmap &= ~mask;
     if (fast) {
-        screen_data.blink_fast_mask |= mask;
-        screen_data.blink_slow_mask &= ~mask;
+        screen_draft.blink_fast_mask |= mask;
+        screen_draft.blink_slow_mask &= ~mask;
     } else {
-        screen_data.blink_fast_mask &= ~mask;
-        screen_data.blink_slow_mask |= mask;
+        screen_draft.blink_fast_mask &= ~mask;
+        screen_draft.blink_slow_mask |= mask;
+    }
+    screen_ungray(mask);
+    screen_unlock(key);
+}
+
+#if SCREEN_GRAY_BITS
+void screen_mask_gray(uint64_t mask, uint8_t level)
+{
+    if ( ! level) {
+        screen_mask_off(mask);
+        return;
+    }
+    if (level >= SCREEN_GRAY_MAX) {
+        screen_mask_on(mask);
+        return;
+    }
+    k_spinlock_key_t key = k_spin_lock(&screen_lock);
+    screen_draft.bitmap &= ~mask;
+    screen_draft.blink_fast_mask &= ~mask;
+    screen_draft.blink_slow_mask &= ~mask;
+    screen_draft.gray_mask |= mask;
+    for (unsigned k = 0; k < SCREEN_GRAY_BITS; k++) {
+        if ((level >> k) & 1)
+            screen_draft.gray[k] |= mask;
+        else
+            screen_draft.gray[k] &= ~mask;
     }
+    screen_unlock(key);
 }
+#endif
 
 // bitmap functions
+uint64_t screen_get()
+{
+    k_spinlock_key_t key = k_spin_lock(&screen_lock);
+    uint64_t bitmap = screen_draft.bitmap;
+    k_spin_unlock(&screen_lock, key);
+    return bitmap;
+}
+
 void screen_set(uint64_t bitmap)
 {
-    // TODO: mutex
-    screen_data.bitmap = bitmap;
-    screen_data.blink_fast_mask = 0;
-    screen_data.blink_slow_mask = 0;
+    k_spinlock_key_t key = k_spin_lock(&screen_lock);
+    screen_draft.bitmap = bitmap;
+    screen_draft.blink_fast_mask = 0;
+    screen_draft.blink_slow_mask = 0;
+    screen_ungray(~0ULL);
+    screen_unlock(key);
+}
+
+// wait one swipe step; returns a pressed button from the filter, if any
+static char screen_step_wait(k_timeout_t pixel_delay, const char *buttons)
+{
+    uint32_t start = k_cycle_get_32();
+    char btn = 0;
+    if (buttons && ! *buttons)
+        k_sleep(pixel_delay);
+    else
+        btn = buttons_get(buttons, pixel_delay);
+
+    // an interrupted step says nothing about pacing
+    if ( ! btn) {
+        uint32_t actual_us = k_cyc_to_us_floor32(k_cycle_get_32() - start);
+        uint32_t requested_us = k_ticks_to_us_floor32(pixel_delay.ticks);
+        screen_stats.step_actual_us += actual_us;
+        screen_stats.step_requested_us += requested_us;
+        stats_hist_add(&screen_stats.step_over_us,
+            actual_us > requested_us ? actual_us - requested_us : 0);
+    }
+    return btn;
+}
+
+// shift in columns horizontally ('L' or 'R'), one column per step, in
+// array order; columns == NULL shifts in blank columns
+static char screen_swipe_columns(const uint8_t *columns, unsigned width,
+    char direction, k_timeout_t pixel_delay, const char *buttons)
+{
+    uint64_t current = screen_get();
+    char btn = 0;
+    for (unsigned i = 0; i < width && ! btn; i++) {
+        uint64_t column = column_to_bitmap(columns ? columns[i] : 0);
+        if (direction == 'L')
+            current = bb_left(current) | column;
+        else
+            current = bb_right(current) | (column << 7);
+        screen_set(current);
+        btn = screen_step_wait(pixel_delay, buttons);
+    }
+    return btn;
+}
+
+uint64_t screen_swipe_frame(uint64_t from, uint64_t to, char direction,
+    unsigned step)
+{
+    if (step == 0)
+        return from;
+    int s = MIN(step, 8);
+    switch(direction) {
+        // to follows from in, s pixels of it shown
+        case 'U':   return (s < 8 ? bb_shift(from, s, 0) : 0) | bb_shift(to, s - 8, 0);
+        case 'D':   return (s < 8 ? bb_shift(from, -s, 0) : 0) | bb_shift(to, 8 - s, 0);
+        case 'L':   return (s < 8 ? bb_shift(from, 0, s) : 0) | bb_shift(to, 0, s - 8);
+        case 'R':   return (s < 8 ? bb_shift(from, 0, -s) : 0) | bb_shift(to, 0, 8 - s);
+        default:
+            printk("[%s] unexpected dir=%c (%02x)\n", __func__, direction, direction);
+            return to;
+    }
 }
 
 char screen_swipe(uint64_t bitmap, char direction, 
     k_timeout_t pixel_delay, const char *buttons)
 {
-    uint64_t current = screen_data.bitmap;
+    uint64_t from = screen_get();
     char btn = 0;
 
-    unsigned glyph_width = 8; // TODO: variable
-    for (unsigned i = 0; i < glyph_width && ! btn; i++) {
-        switch(direction) {
-            case 'U':
-                current = (current << 8) | (bitmap >> 56);
-                bitmap <<= 8;
-                break;
-            case 'D':
-                current = (current >> 8) | (bitmap << 56);
-                bitmap >>= 8;
-                break;
-            case 'L':
-                current = ((current << 1) & ~H_MASK) | ((bitmap >> 7) & H_MASK);
-                bitmap <<= 1;
-                break;
-            case 'R':
-                current = ((current & ~H_MASK) >> 1) | ((bitmap & H_MASK) << 7);
-                bitmap >>= 1;
+    for (unsigned i = 1; i <= 8 && ! btn; i++) {
+        screen_set(screen_swipe_frame(from, bitmap, direction, i)); // note: this stops all blinks
+        btn = screen_step_wait(pixel_delay, buttons);
+    }
+    return btn;
+}
+
+// text strip functions
+static struct screen_strip_cache_t {
+    uint32_t last_use;
+    struct screen_strip_t strip;
+} strip_cache[SCREEN_STRIP_CACHE];
+
+static uint16_t layout_glyphs[LAYOUT_MAX];
+
+// lay text out once into the columns it scrolls in, in shift order: glyphs
+// in visual order (reversed when scrolling right), each glyph's columns
+// reversed when scrolling right, marks merged into their base glyph
+static void screen_strip_render(struct screen_strip_t *strip,
+    const char *text, char direction)
+{
+    strip->text = text;
+    strip->direction = direction;
+    strip->lead = 0;
+    unsigned n = layout_text(text, direction == 'R', layout_glyphs);
+    unsigned width = 0;
+    unsigned prev = 0, prev_width = 0; // last spacing glyph in the strip
+    bool full = false;
+    for (unsigned k = 0; k < n && ! full; ) {
+        // next cluster (a glyph and its marks), in the order it scrolls in
+        unsigned from, to;
+        if (direction == 'L') {
+            from = k;
+            to = from + 1;
+            while (to < n && layout_is_mark(layout_glyphs[to])) to++;
+        } else {
+            to = n - k;
+            from = to - 1;
+            while (from > 0 && layout_is_mark(layout_glyphs[from])) from--;
+        }
+        k += to - from;
+
+        for (unsigned i = from; i < to; i++) {
+            uint8_t buf[FONTPACK_GLYPH_SIZE], info;
+            const uint8_t *columns = glyph_lookup(layout_glyphs[i], &info, buf);
+            unsigned glyph_width = info & FONTPACK_WIDTH;
+
+            if ((info & FONTPACK_COMBINING) && i != from) {
+                // overlay the mark on its base glyph, in visual column order
+                glyph_width = MIN(glyph_width, prev_width);
+                unsigned at = (prev_width - glyph_width) / 2;
+                if (info & FONTPACK_ALIGN_START) at = 0;
+                if (info & FONTPACK_ALIGN_END) at = prev_width - glyph_width;
+                for (unsigned c = 0; c < glyph_width; c++) {
+                    unsigned x = at + c;
+                    strip->columns[prev + (direction == 'L' ? x : prev_width - 1 - x)] |= columns[c];
+                }
+                continue;
+            }
+
+            if (width + glyph_width + GLYPH_GAP > SCREEN_STRIP_MAX) {
+                printk("[%s] text truncated at %u columns\n", __func__, width);
+                full = true;
                 break;
-            default:
-                printk("[%s] unexpected dir=%c (%02x)\n", __func__, direction, direction);
+            }
+            prev = width;
+            prev_width = glyph_width;
+            for (unsigned c = 0; c < glyph_width; c++)
+                strip->columns[width++] = columns[direction == 'L' ? c : glyph_width - 1 - c];
+            for (unsigned c = 0; c < GLYPH_GAP; c++)
+                strip->columns[width++] = 0;
+            if ( ! strip->lead) strip->lead = width;
         }
-        screen_set(current); // note: this stops all blinks
-        
-        if (buttons && ! *buttons)
-            k_sleep(pixel_delay);
-        else
-            btn = buttons_get(buttons, pixel_delay);
     }
+    strip->width = width;
+}
+
+const struct screen_strip_t *screen_strip_get(const char *text, char direction,
+    bool cache)
+{
+    static uint32_t use_count = 0;
+    struct screen_strip_cache_t *lru = &strip_cache[0];
+    for (unsigned i = 0; i < ARRAY_SIZE(strip_cache); i++) {
+        struct screen_strip_cache_t *entry = &strip_cache[i];
+        if (cache && entry->strip.text == text && entry->strip.direction == direction) {
+            entry->last_use = ++use_count;
+            return &entry->strip;
+        }
+        if (entry->last_use < lru->last_use)
+            lru = entry;
+    }
+    screen_strip_render(&lru->strip, text, direction);
+    if ( ! cache)
+        lru->strip.text = NULL;
+    lru->last_use = ++use_count;
+    return &lru->strip;
+}
+
+char screen_strip_scroll(const struct screen_strip_t *strip, unsigned from,
+    k_timeout_t pixel_delay, const char *buttons)
+{
+    if (from >= strip->width)
+        return 0;
+    return screen_swipe_columns(strip->columns + from, strip->width - from,
+        strip->direction, pixel_delay, buttons);
+}
+
+char screen_strip_scroll_infinite(const struct screen_strip_t *strip,
+    k_timeout_t pixel_delay, const char *buttons)
+{
+    char btn;
+    do {
+        btn = screen_strip_scroll(strip, 0, pixel_delay, buttons);
+        if ( ! btn) btn = screen_swipe(0, strip->direction, pixel_delay, buttons);
+    } while ( ! btn);
+
     return btn;
 }
 
@@ -317,11 +918,16 @@ char screen_swipe(uint64_t bitmap, char direction,
 char screen_scroll_once(const char *text, char direction, 
     k_timeout_t pixel_delay, const char *buttons)
 {
+    if (direction == 'L' || direction == 'R')
+        return screen_strip_scroll(screen_strip_get(text, direction, false),
+            0, pixel_delay, buttons);
+
     char btn = 0;
-    while(*text && ! btn) {
-        char ch = *text++;
-        if (ch == UTF8_HEBREW_MSB) ch = *text++;
-        btn = screen_swipe(get_glyph(ch), direction, pixel_delay, buttons);
+    unsigned n = layout_text(text, settings.lang == LANG_HE, layout_glyphs);
+    glyph_prefetch(layout_glyphs, n); // before the first swipe, not between
+    for (unsigned i = 0; i < n && ! btn; i++) {
+        if ( ! layout_is_mark(layout_glyphs[i]))
+            btn = screen_swipe(glyph_bitmap(layout_glyphs[i]), direction, pixel_delay, buttons);
     }
     return btn;
 }
@@ -329,6 +935,10 @@ char screen_scroll_once(const char *text, char direction,
 char screen_scroll_infinite(const char *text, char direction, 
     k_timeout_t pixel_delay, const char *buttons)
 {
+    if (direction == 'L' || direction == 'R')
+        return screen_strip_scroll_infinite(screen_strip_get(text, direction, false),
+            pixel_delay, buttons);
+
     char btn;
     do {
         btn = screen_scroll_once(text, direction, pixel_delay, buttons);
@@ -10,11 +10,29 @@
 
 #include <zephyr/kernel.h>
 
-// the following are in Hertz
+// the following are in Hertz; the screen only refreshes when its content
+// changes or a blink phase flips, at most SCREEN_FPS times a second
 #define SCREEN_FPS          50
 #define SCREEN_BLINK_FAST   10
 #define SCREEN_BLINK_SLOW   2
 
+// per-pixel grayscale, rendered as binary-code-modulated subframes on top
+// of the global dimming; set SCREEN_GRAY_BITS to 0 to compile it out
+#define SCREEN_GRAY_BITS    3   // 2 to 4
+#define SCREEN_GRAY_MAX     ((1 << SCREEN_GRAY_BITS) - 1)
+#define SCREEN_GRAY_HZ      100 // full modulation cycles per second
+
+// orientation, applied when the frame is sent to the display
+enum screen_orientation {
+    SCREEN_ORIENT_0 = 0,    // clockwise rotations
+    SCREEN_ORIENT_90 = 1,
+    SCREEN_ORIENT_180 = 2,
+    SCREEN_ORIENT_270 = 3,
+    SCREEN_ORIENT_MIRROR = 4, // or-ed with a rotation, mirrors left-right
+    SCREEN_ORIENT_END = 8   /* keep last */
+};
+void screen_set_orientation(enum screen_orientation orientation);
+
 // blinkall functions
 enum blink_speed {
     BLINK_NONE = 0,
@@ -24,11 +42,24 @@ enum blink_speed {
 };
 void screen_blinkall(enum blink_speed bs);
 
+// prints display pipeline counters (frame time, lateness, deadline misses,
+// dropped frames, pixels and I2C bytes/time per flush, swipe pacing) to
+// the console, then resets them
+void screen_print_stats();
+
+// batch functions: edits made between screen_begin() and screen_commit()
+// are shown together; all functions here may be called from input callbacks
+void screen_begin();
+void screen_commit();
+
 // mask functions
 void screen_mask_on(uint64_t mask);
 void screen_mask_off(uint64_t mask);
 void screen_mask_invert(uint64_t mask);
 void screen_mask_blink(uint64_t mask, bool fast);
+#if SCREEN_GRAY_BITS
+void screen_mask_gray(uint64_t mask, uint8_t level); // 0 to SCREEN_GRAY_MAX
+#endif
 
 // pixel functions
 inline void screen_pixel_on(uint8_t pos)
@@ -47,15 +78,51 @@ inline void screen_pixel_blink(uint8_t pos, bool fast)
 {
     screen_mask_blink(1ULL << pos, fast);
 }
+#if SCREEN_GRAY_BITS
+inline void screen_pixel_gray(uint8_t pos, uint8_t level)
+{
+    screen_mask_gray(1ULL << pos, level);
+}
+#endif
 
 // bitmap functions
 uint64_t get_glyph(char ch);
 
+uint64_t screen_get();
 void screen_set(uint64_t bitmap);
 
+// frame step (0 to 8) of a swipe of to over from
+uint64_t screen_swipe_frame(uint64_t from, uint64_t to, char direction,
+    unsigned step);
 char screen_swipe(uint64_t bitmap, char direction, 
     k_timeout_t pixel_delay, const char *buttons);
 
+// text strip functions: a string rendered once into the columns it
+// scrolls in ('L' or 'R'), so scrolling is a sliding window over them
+#define SCREEN_STRIP_MAX    144 // columns
+#define SCREEN_STRIP_CACHE  2   // strips kept, least recently used evicted;
+                            // the shown menu item and the one before it
+
+struct screen_strip_t {
+    const char *text;       // cache key, NULL if not cached
+    char direction;
+    uint8_t lead;           // columns of the first glyph (and its gap)
+    uint16_t width;
+    uint8_t columns[SCREEN_STRIP_MAX];
+};
+
+// cache = true keys the strip by the text pointer, so only use it for
+// strings that never change (e.g. menu labels); the strip stays valid
+// until SCREEN_STRIP_CACHE other strips are requested
+const struct screen_strip_t *screen_strip_get(const char *text, char direction,
+    bool cache);
+
+char screen_strip_scroll(const struct screen_strip_t *strip, unsigned from,
+    k_timeout_t pixel_delay, const char *buttons);
+
+char screen_strip_scroll_infinite(const struct screen_strip_t *strip,
+    k_timeout_t pixel_delay, const char *buttons);
+
 // text functions
 char screen_scroll_once(const char *text, char direction, 
     k_timeout_t pixel_delay, const char *buttons);
@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2025 Benny Meisels <benny.meisels@gmail.com>
+ *                    Rani Hod <rani.hod@gmail.com>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+
+#include <zephyr/drivers/eeprom.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/printk.h>
+
+#include "shadow.h"
+
+BUILD_ASSERT(EEPROM_SHADOW_OFFSET % EEPROM_PAGE_SIZE == 0);
+BUILD_ASSERT(EEPROM_SHADOW_SIZE % EEPROM_PAGE_SIZE == 0);
+BUILD_ASSERT(EEPROM_SHADOW_OFFSET > 0, "offset 0 marks a free slot");
+BUILD_ASSERT(SHADOW_SLOTS <= 32, "one dirty bit per slot");
+
+static const struct device *shadow_eeprom;
+static struct shadow_slot_t {
+	unsigned offset;	// EEPROM offset of the page, 0 if none
+	uint8_t data[EEPROM_PAGE_SIZE];
+} shadow_slots[SHADOW_SLOTS];
+static unsigned shadow_last;	// slot used last, kept on a miss
+static atomic_t shadow_dirty;	// bit per slot
+static int shadow_error;		// of the last write-back
+static struct k_spinlock shadow_lock;
+
+static void shadow_work_func(struct k_work *work);
+static K_WORK_DELAYABLE_DEFINE(shadow_work, shadow_work_func);
+
+static void shadow_work_func(struct k_work *work)
+{
+	uint8_t page[EEPROM_PAGE_SIZE];
+	uint32_t dirty = atomic_clear(&shadow_dirty);
+
+	while (dirty) {
+		unsigned s = __builtin_ctz(dirty);
+		dirty &= dirty - 1;
+
+		// a copy, as the UI thread may write the slot meanwhile; it
+		// marks the slot dirty again then. It only reuses a slot after
+		// this work is done.
+		k_spinlock_key_t lock = k_spin_lock(&shadow_lock);
+		memcpy(page, shadow_slots[s].data, sizeof(page));
+		k_spin_unlock(&shadow_lock, lock);
+
+		int rc = eeprom_write(shadow_eeprom, shadow_slots[s].offset, page, sizeof(page));
+		if (rc < 0) {
+			printk("[%s] write error; offset=0x%x code=%d.\n", __func__,
+				shadow_slots[s].offset, rc);
+			atomic_or(&shadow_dirty, BIT(s) | dirty); // for the next try
+			shadow_error = rc;
+			return;
+		}
+	}
+	shadow_error = 0;
+}
+
+int shadow_init(const struct device *eeprom)
+{
+	shadow_eeprom = eeprom;
+	return 0;
+}
+
+// the slot of the page at offset, read in if needed; a slot is only
+// reused once all write-backs are done
+static int shadow_slot(unsigned offset)
+{
+	for (unsigned s = 0; s < SHADOW_SLOTS; s++)
+		if (shadow_slots[s].offset == offset)
+			return shadow_last = s;
+
+	int rc = shadow_flush();
+	if (rc < 0)
+		return rc;
+	unsigned s = (shadow_last + 1) % SHADOW_SLOTS;
+	shadow_slots[s].offset = 0;
+	rc = eeprom_read(shadow_eeprom, offset, shadow_slots[s].data, EEPROM_PAGE_SIZE);
+	if (rc < 0) {
+		printk("[%s] read error; offset=0x%x code=%d.\n", __func__, offset, rc);
+		return rc;
+	}
+	shadow_slots[s].offset = offset;
+	return shadow_last = s;
+}
+
+// the part of [offset, offset + len) in the page at page, as an offset
+// into the page and a length
+static size_t shadow_span(unsigned offset, size_t len, unsigned page, unsigned *from)
+{
+	unsigned start = MAX(offset, page);
+	*from = start - page;
+	return MIN(offset + len, page + EEPROM_PAGE_SIZE) - start;
+}
+
+static bool shadow_covers(unsigned offset, size_t len)
+{
+	offset -= EEPROM_SHADOW_OFFSET; // wraps around below the shadow
+	return offset <= EEPROM_SHADOW_SIZE && len <= EEPROM_SHADOW_SIZE - offset;
+}
+
+int shadow_read(unsigned offset, void *data, size_t len)
+{
+	if ( ! shadow_covers(offset, len))
+		return -EINVAL;
+	uint8_t *out = data;
+	for (unsigned page = ROUND_DOWN(offset, EEPROM_PAGE_SIZE); page < offset + len;
+		page += EEPROM_PAGE_SIZE) {
+		int s = shadow_slot(page);
+		if (s < 0)
+			return s;
+		unsigned from;
+		size_t n = shadow_span(offset, len, page, &from);
+		k_spinlock_key_t lock = k_spin_lock(&shadow_lock);
+		memcpy(out, &shadow_slots[s].data[from], n);
+		k_spin_unlock(&shadow_lock, lock);
+		out += n;
+	}
+	return 0;
+}
+
+int shadow_write(unsigned offset, const void *data, size_t len)
+{
+	if ( ! shadow_covers(offset, len))
+		return -EINVAL;
+	if (len == 0)
+		return 0;
+	const uint8_t *in = data;
+	for (unsigned page = ROUND_DOWN(offset, EEPROM_PAGE_SIZE); page < offset + len;
+		page += EEPROM_PAGE_SIZE) {
+		int s = shadow_slot(page);
+		if (s < 0)
+			return s;
+		unsigned from;
+		size_t n = shadow_span(offset, len, page, &from);
+		k_spinlock_key_t lock = k_spin_lock(&shadow_lock);
+		bool changed = memcmp(&shadow_slots[s].data[from], in, n) != 0;
+		if (changed)
+			memcpy(&shadow_slots[s].data[from], in, n);
+		k_spin_unlock(&shadow_lock, lock);
+		in += n;
+		if (changed) {
+			atomic_or(&shadow_dirty, BIT(s));
+			k_work_reschedule(&shadow_work, SHADOW_FLUSH_DELAY);
+		}
+	}
+	return 0;
+}
+
+int shadow_flush()
+{
+	struct k_work_sync sync;
+
+	if (atomic_get(&shadow_dirty))
+		k_work_reschedule(&shadow_work, K_NO_WAIT);
+	k_work_flush_delayable(&shadow_work, &sync); // also a write-back under way
+	return atomic_get(&shadow_dirty) ? shadow_error : 0;
+}
@@ -0,0 +1,37 @@
+/*
+ * Copyright (c) 2025 Benny Meisels <benny.meisels@gmail.com>
+ *                    Rani Hod <rani.hod@gmail.com>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef __SHADOW_H__
+#define __SHADOW_H__
+
+#include <zephyr/kernel.h>
+
+#include "persist.h"
+
+// A write-behind cache of SHADOW_SLOTS EEPROM pages, within the
+// EEPROM_SHADOW_SIZE bytes at EEPROM_SHADOW_OFFSET: the highscores and
+// the settings log. Reads and writes go to the cached page, which is
+// read in first if needed; writes mark it dirty and return at once. A
+// work item writes the dirty pages back a little later, whole pages at a
+// time, so saves in a row cost one page write per page they touched.
+// Bringing in another page waits for the write-backs, so only a save to
+// a page that is not cached waits, e.g. when the settings log moves on
+// to its next page.
+#define SHADOW_FLUSH_DELAY	K_MSEC(50)
+#define SHADOW_SLOTS		2	// pages kept in RAM
+
+int shadow_init(const struct device *eeprom);
+
+// offsets are EEPROM offsets; -EINVAL outside the shadow
+int shadow_read(unsigned offset, void *data, size_t len);
+int shadow_write(unsigned offset, const void *data, size_t len);
+
+// write back all dirty pages now and wait; for when the board may be
+// switched off or reset soon
+int shadow_flush();
+
+#endif // __SHADOW_H__
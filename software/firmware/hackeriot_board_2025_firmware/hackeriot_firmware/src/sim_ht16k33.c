@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2025 Benny Meisels <benny.meisels@gmail.com>
+ *                    Rani Hod <rani.hod@gmail.com>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// HT16K33 emulator for native_sim: takes the driver's and screen.c's I2C
+// writes, and redraws the matrix at the top of the terminal after each
+// transaction, with the console scrolling below it. Display RAM writes
+// are counted, for comparing render paths at host speed.
+
+#define DT_DRV_COMPAT holtek_ht16k33
+
+#include <string.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/emul.h>
+#include <zephyr/drivers/i2c.h>
+#include <zephyr/drivers/i2c_emul.h>
+#include <zephyr/sys/printk.h>
+
+#define HT16K33_CMD_DISP_DATA_ADDR	0x00	// low nibble: display RAM address
+#define HT16K33_CMD_SYSTEM_SETUP	0x20	// bit 0: oscillator
+#define HT16K33_CMD_DISP_SETUP		0x80	// bit 0: on, bits 1-2: blink
+#define HT16K33_CMD_DIMMING			0xE0	// low nibble: duty - 1
+
+#define SIM_HT16K33_LINES	10		// drawn at the top of the terminal
+
+struct sim_ht16k33_data {
+	uint8_t ram[16];		// 8 rows (COM0-7) of 2 bytes
+	bool oscillator;
+	bool display_on;
+	uint8_t blink;
+	uint8_t dimming;
+	uint32_t ram_writes;	// transactions writing display RAM
+	uint32_t ram_bytes;		// display RAM bytes written
+};
+
+// drawn as on the board2025, upright: COM0 on top and ROW0 on the left,
+// undoing the rotation screen.c applies for it
+static void sim_ht16k33_draw(const struct sim_ht16k33_data *data)
+{
+	static const char * const blink[] = {"", " blink 2Hz", " blink 1Hz", " blink 0.5Hz"};
+
+	printk("\0337\033[1;1H"); // save the cursor, go home
+	for (unsigned com = 0; com < 8; com++) {
+		printk("  ");
+		for (unsigned row = 0; row < 8; row++)
+			printk((data->ram[2 * com] & BIT(row)) ? "██" : " .");
+		printk("\033[K\n");
+	}
+	printk("  %s%s dim %u/16, %u RAM writes, %u bytes\033[K\n",
+		(data->oscillator && data->display_on) ? "on" : "off", blink[data->blink & 3],
+		data->dimming + 1, data->ram_writes, data->ram_bytes);
+	printk("\033[K\0338"); // restore the cursor
+}
+
+static int sim_ht16k33_transfer(const struct emul *target, struct i2c_msg *msgs,
+	int num_msgs, int addr)
+{
+	struct sim_ht16k33_data *data = target->data;
+
+	// consecutive writes are one stream, the command byte first; a burst
+	// write sends the RAM address and the data as separate messages
+	int cmd = -1;
+	unsigned ram_addr = 0;
+	for (int i = 0; i < num_msgs; i++) {
+		struct i2c_msg *msg = &msgs[i];
+		if (msg->flags & I2C_MSG_READ) {
+			memset(msg->buf, 0, msg->len); // key RAM: nothing pressed
+			continue;
+		}
+		for (unsigned j = 0; j < msg->len; j++) {
+			uint8_t byte = msg->buf[j];
+			if (cmd < 0) {
+				cmd = byte;
+				ram_addr = byte & 0x0F;
+			} else if ((cmd & 0xF0) == HT16K33_CMD_DISP_DATA_ADDR) {
+				data->ram[ram_addr++ & 0x0F] = byte;
+				++data->ram_bytes;
+			}
+		}
+	}
+
+	switch (cmd & 0xF0) {
+		case HT16K33_CMD_DISP_DATA_ADDR:
+			++data->ram_writes;
+			break;
+		case HT16K33_CMD_SYSTEM_SETUP:
+			data->oscillator = cmd & 1;
+			break;
+		case HT16K33_CMD_DISP_SETUP:
+			data->display_on = cmd & 1;
+			data->blink = (cmd >> 1) & 3;
+			break;
+		case HT16K33_CMD_DIMMING:
+			data->dimming = cmd & 0x0F;
+			break;
+	}
+	sim_ht16k33_draw(data);
+	return 0;
+}
+
+static const struct i2c_emul_api sim_ht16k33_api = {
+	.transfer = sim_ht16k33_transfer,
+};
+
+static int sim_ht16k33_init(const struct emul *target, const struct device *parent)
+{
+	// keep the console below the matrix
+	printk("\033[2J\033[%u;r\033[%u;1H", SIM_HT16K33_LINES + 1, SIM_HT16K33_LINES + 1);
+	sim_ht16k33_draw(target->data);
+	return 0;
+}
+
+#define SIM_HT16K33_DEFINE(n)									\
+	static struct sim_ht16k33_data sim_ht16k33_data_##n;		\
+	EMUL_DT_INST_DEFINE(n, sim_ht16k33_init, &sim_ht16k33_data_##n, NULL,	\
+		&sim_ht16k33_api, NULL)
+
+DT_INST_FOREACH_STATUS_OKAY(SIM_HT16K33_DEFINE)
@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2025 Benny Meisels <benny.meisels@gmail.com>
+ *                    Rani Hod <rani.hod@gmail.com>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Keyboard buttons for native_sim: keys read from the console press the
+// gpio-keys on their emulated GPIOs. A terminal only reports presses, so
+// a press holds its button SIM_KEY_HOLD_MS, past the terminal's
+// auto-repeat delay (250 to 600 ms, typically), and each auto-repeated
+// keystroke keeps it held SIM_KEY_REPEAT_MS more, past the repeat
+// interval. So a held key stays down without gaps, though a tap stays
+// down SIM_KEY_HOLD_MS as well. The D-pad is the arrow keys or WASD; A
+// and B are Z and X.
+
+#include <zephyr/kernel.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/drivers/gpio.h>
+#include <zephyr/drivers/gpio/gpio_emul.h>
+#include <zephyr/drivers/uart.h>
+#include <zephyr/input/input.h>
+
+#define BTN_NODE DT_COMPAT_GET_ANY_STATUS_OKAY(gpio_keys)
+
+#define SIM_KEY_HOLD_MS		700
+#define SIM_KEY_REPEAT_MS	150
+#define SIM_KEY_POLL_MS		10
+
+#define SIM_BUTTON(node) { GPIO_DT_SPEC_GET(node, gpios), DT_PROP(node, zephyr_code) },
+static const struct sim_button_t {
+	struct gpio_dt_spec gpio;
+	uint16_t code;
+} sim_buttons[] = {
+	DT_FOREACH_CHILD(BTN_NODE, SIM_BUTTON)
+};
+
+// the input code for a key, 0 for none; esc tracks arrow key sequences
+static uint16_t sim_key_code(uint8_t c, uint8_t *esc)
+{
+	if (*esc == 1) {
+		*esc = (c == '[') ? 2 : 0;
+		return 0;
+	}
+	if (*esc == 2) {
+		*esc = 0;
+		switch (c) {
+			case 'A': return INPUT_BTN_DPAD_UP;
+			case 'B': return INPUT_BTN_DPAD_DOWN;
+			case 'C': return INPUT_BTN_DPAD_RIGHT;
+			case 'D': return INPUT_BTN_DPAD_LEFT;
+			default: return 0;
+		}
+	}
+	switch (c) {
+		case '\033': *esc = 1; return 0;
+		case 'w': return INPUT_BTN_DPAD_UP;
+		case 'a': return INPUT_BTN_DPAD_LEFT;
+		case 's': return INPUT_BTN_DPAD_DOWN;
+		case 'd': return INPUT_BTN_DPAD_RIGHT;
+		case 'z': return INPUT_BTN_A;
+		case 'x': return INPUT_BTN_B;
+		default: return 0;
+	}
+}
+
+static void sim_keys_thread(void *p1, void *p2, void *p3)
+{
+	const struct device *const uart = DEVICE_DT_GET(DT_CHOSEN(zephyr_console));
+	int64_t release[ARRAY_SIZE(sim_buttons)] = {0}; // 0 while not held
+	uint8_t esc = 0;
+
+	while (1) {
+		uint8_t c;
+		while (uart_poll_in(uart, &c) == 0) {
+			uint16_t code = sim_key_code(c, &esc);
+			for (unsigned i = 0; i < ARRAY_SIZE(sim_buttons) && code; i++) {
+				if (sim_buttons[i].code != code)
+					continue;
+				int64_t now = k_uptime_get();
+				if (release[i])
+					release[i] = MAX(release[i], now + SIM_KEY_REPEAT_MS);
+				else {
+					gpio_emul_input_set(sim_buttons[i].gpio.port, sim_buttons[i].gpio.pin, 1);
+					release[i] = now + SIM_KEY_HOLD_MS;
+				}
+			}
+		}
+
+		int64_t now = k_uptime_get();
+		for (unsigned i = 0; i < ARRAY_SIZE(sim_buttons); i++) {
+			if (release[i] && now >= release[i]) {
+				gpio_emul_input_set(sim_buttons[i].gpio.port, sim_buttons[i].gpio.pin, 0);
+				release[i] = 0;
+			}
+		}
+		k_msleep(SIM_KEY_POLL_MS);
+	}
+}
+
+K_THREAD_DEFINE(sim_keys, 1024, sim_keys_thread, NULL, NULL, NULL,
+	K_LOWEST_APPLICATION_THREAD_PRIO, 0, 0);
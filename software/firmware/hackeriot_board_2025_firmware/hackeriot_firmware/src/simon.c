@@ -6,13 +6,15 @@
  */
 
 #include <zephyr/drivers/led.h>
-#include <zephyr/random/random.h>
 #include <zephyr/sys/printk.h>
+#include <string.h>
 
-#include "buttons.h"
+#include "bitboard.h"
+#include "game.h"
 #include "screen.h"
 #include "simon.h"
 #include "persist.h"
+#include "replay.h"
 
 #define SIMON_OPTIONS   "UDLRAB"
 
@@ -25,73 +27,221 @@ static char simon_dir(char dir)
         case 'R':
             break;
         default:
-            dir = "UDLR"[sys_rand8_get() & 3];            
+            dir = "UDLR"[replay_rand8() & 3];            
     }
     //printf("[%s] dir=%c\n", __func__, dir);
     return dir;
 }
 
+#define SIMON_GLYPH_UP BB_ROWS( \
+    0b00011000, \
+    0b00111100, \
+    0b01111110, \
+    0b11111111, \
+    0b00011000, \
+    0b00011000, \
+    0b00011000, \
+    0b00011000)
+#define SIMON_GLYPH_LEFT BB_ROWS( \
+    0b00010000, \
+    0b00110000, \
+    0b01110000, \
+    0b11111111, \
+    0b11111111, \
+    0b01110000, \
+    0b00110000, \
+    0b00010000)
+#define SIMON_GLYPH_A BB_ROWS( \
+    0b00111100, \
+    0b01111110, \
+    0b11100111, \
+    0b11000011, \
+    0b11111111, \
+    0b11111111, \
+    0b11000011, \
+    0b11000011)
+#define SIMON_GLYPH_B BB_ROWS( \
+    0b11111110, \
+    0b11000011, \
+    0b11000011, \
+    0b11111110, \
+    0b11111110, \
+    0b11000011, \
+    0b11000011, \
+    0b11111110)
+#define SIMON_GLYPH_CLOCK BB_ROWS( \
+    0b01111110, \
+    0b11000011, \
+    0b10010001, \
+    0b10010001, \
+    0b10011101, \
+    0b10000001, \
+    0b11000011, \
+    0b01111110)
+
 static uint64_t simon_glyph(char ch)
 {
     switch(ch) {
-        case 'U':   return 0x183C7EFF18181818;
-        case 'D':   return 0x18181818FF7E3C18;
-        case 'L':   return 0x103070FFFF703010;
-        case 'R':   return 0x080C0EFFFF0E0C08;
-        case 'A':   return 0x3C7EE7C3FFFFC3C3;
-        case 'B':   return 0xFEC3C3FEFEC3C3FE;
-        case 0:     return 0x7EC391919D81C37E; // clock
+        case 'U':   return SIMON_GLYPH_UP;
+        case 'D':   return bb_flip_vertical(SIMON_GLYPH_UP);
+        case 'L':   return SIMON_GLYPH_LEFT;
+        case 'R':   return bb_flip_horizontal(SIMON_GLYPH_LEFT);
+        case 'A':   return SIMON_GLYPH_A;
+        case 'B':   return SIMON_GLYPH_B;
+        case 0:     return SIMON_GLYPH_CLOCK;
         default:    return 0;
     };
 }
 
-static bool do_one_round(struct simon_data_t *sd)
+static void simon_swipe(struct simon_data_t *sd, uint64_t bitmap, char dir)
 {
-    // display sequence
-    printk("Simon:");
-    for (unsigned i = 0; i < sd->len; i++) {
-        char ch = sd->seq[i];
-        printk(" %c", ch);
-        screen_swipe(simon_glyph(ch), simon_dir(ch), PIXEL_DELAY, "");
-        k_msleep(SIMON_DELAY);
+    sd->from = screen_swipe_frame(sd->from, sd->to, sd->dir, sd->step);
+    sd->to = bitmap;
+    sd->dir = dir;
+    sd->step = 0;
+}
+
+// true while the phase still waits
+static bool simon_waiting(struct simon_data_t *sd)
+{
+    if (sd->wait_ms <= 0)
+        return false;
+    sd->wait_ms -= sd->tick_ms;
+    return true;
+}
+
+static void simon_input(void *state, char btn)
+{
+    struct simon_data_t *sd = state;
+    // presses during the show are ignored, as before the query
+    if (sd->phase == SIMON_SHOW || sd->phase > SIMON_QUERY)
+        return;
+    if (sd->n_keys < ARRAY_SIZE(sd->keys))
+        sd->keys[sd->n_keys++] = btn;
+}
+
+static bool simon_update(void *state)
+{
+    struct simon_data_t *sd = state;
+    if (sd->step < 8) {
+        ++sd->step;
+        return true;
     }
-    printk("\n");
-    buttons_clear();
-    screen_swipe(get_glyph('?'), LANG_DIR, PIXEL_DELAY, "");
-
-    bool game_on = true;
-    // query sequence
-    printk("Player:");
-    for (unsigned i = 0; i < sd->len && game_on; i++) {
-        char ch = buttons_get(SIMON_OPTIONS, K_MSEC(2 * SIMON_DELAY));
-        if (ch) printk(" %c", ch); else printk(" (none)");
-        uint64_t bitmap = simon_glyph(ch);
-        screen_swipe(bitmap, simon_dir(ch), PIXEL_DELAY, "");
-        if (ch != sd->seq[i]) game_on = false;
+    // a press cuts the query wait short
+    if ( ! (sd->phase == SIMON_QUERY && sd->n_keys) && simon_waiting(sd))
+        return true;
+
+    switch (sd->phase) {
+        case SIMON_SHOW:
+            if (sd->pos == 0)
+                printk("Simon:");
+            if (sd->pos < sd->len) {
+                char ch = sd->seq[sd->pos++];
+                printk(" %c", ch);
+                simon_swipe(sd, simon_glyph(ch), simon_dir(ch));
+                sd->wait_ms = SIMON_DELAY;
+                break;
+            }
+            printk("\nPlayer:");
+            sd->phase = SIMON_PROMPT;
+            sd->pos = 0;
+            sd->n_keys = 0;
+            simon_swipe(sd, get_glyph('?'), LANG_DIR);
+            break;
+
+        case SIMON_PROMPT:
+            sd->phase = SIMON_QUERY;
+            sd->wait_ms = 2 * SIMON_DELAY;
+            break;
+
+        case SIMON_QUERY: {
+            // a press, or none in time
+            char ch = 0;
+            if (sd->n_keys) {
+                ch = sd->keys[0];
+                memmove(sd->keys, sd->keys + 1, --sd->n_keys);
+            }
+            if (ch) printk(" %c", ch); else printk(" (none)");
+            simon_swipe(sd, simon_glyph(ch), simon_dir(ch));
+            sd->wait_ms = 2 * SIMON_DELAY;
+            if (ch != sd->seq[sd->pos]) {
+                printk(" error\n");
+                sd->phase = SIMON_FAIL;
+                sd->pos = 0;
+                sd->wait_ms = 0;
+            } else if (++sd->pos == sd->len) {
+                printk(" OK\n");
+                sd->phase = SIMON_OK;
+                sd->pos = 0;
+                sd->wait_ms = 0;
+            }
+            break;
+        }
+
+        case SIMON_OK:
+            if (sd->pos++ == 0) {
+                simon_swipe(sd, SIMON_GLYPH_OK, 'R');
+                sd->wait_ms = 2000;
+                break;
+            }
+            ++sd->points;
+            if (sd->len == SIMON_MAX_LEN)
+                return false; // nothing left to add
+            ++sd->len;
+            sd->phase = SIMON_SHOW;
+            sd->pos = 0;
+            break;
+
+        case SIMON_FAIL:
+            if (sd->pos++ == 0) {
+                sd->wait_ms = 3000;
+                break;
+            }
+            return false;
     }
-    printk(" %s\n", game_on ? "OK" : "error");
-
-    if (game_on) {
-        screen_swipe(SIMON_GLYPH_OK, 'R', PIXEL_DELAY, "");
-        k_msleep(2000);
-    } else {
-        screen_blinkall(BLINK_2HZ);
-        k_msleep(3000);
-        screen_blinkall(BLINK_NONE);
+    return true;
+}
+
+static void simon_render(const void *state)
+{
+    const struct simon_data_t *sd = state;
+    static enum blink_speed blink = BLINK_NONE;
+
+    screen_set(screen_swipe_frame(sd->from, sd->to, sd->dir, sd->step));
+    enum blink_speed bs = (sd->phase == SIMON_FAIL && sd->pos) ? BLINK_2HZ : BLINK_NONE;
+    if (bs != blink) {
+        screen_blinkall(bs);
+        blink = bs;
     }
-    return game_on;
 }
 
+static uint32_t simon_tick_ms(const void *state)
+{
+    const struct simon_data_t *sd = state;
+    return sd->tick_ms;
+}
+
+static const struct game_t simon = {
+    .name       = "simon",
+    .buttons    = SIMON_OPTIONS,
+    .input      = simon_input,
+    .update     = simon_update,
+    .render     = simon_render,
+    .tick_ms    = simon_tick_ms,
+};
+
 unsigned play_simon()
 {
     printk("[%s] new game\n", __func__);
+    // the scroll speed at the start, which a replay sets to the recorded one
     struct simon_data_t sd = {
         .points = 0,
         .len = INITIAL_SIMON_LEN,
+        .tick_ms = settings.speed,
     };
     // randomize sequence
     for (unsigned i = 0; i < ARRAY_SIZE(sd.seq); i++)
-        sd.seq[i] = SIMON_OPTIONS[sys_rand32_get() % (ARRAY_SIZE(SIMON_OPTIONS)-1)];
+        sd.seq[i] = SIMON_OPTIONS[replay_rand32() % (ARRAY_SIZE(SIMON_OPTIONS)-1)];
 
     // display Ready-3-2-1
     const char *msg[] = {"Ready?", "מוכנה?"};
@@ -102,11 +252,10 @@ unsigned play_simon()
     }
 
     // game loop
-    while(do_one_round(&sd))
-    {
-        ++sd.len;
-        ++sd.points;
-    }
+    sd.from = sd.to = screen_get();
+    sd.step = 8;
+    game_run(&simon, &sd, GAME_REALTIME);
+    screen_blinkall(BLINK_NONE);
 
     printk("[%s] game ended, score=%u\n", __func__, sd.points);
     return sd.points;
@@ -8,16 +8,44 @@
 #ifndef __SIMON_H__
 #define __SIMON_H__
 
+#include "bitboard.h"
+
 #define INITIAL_SIMON_LEN 3
 #define SIMON_DELAY 700
 #define SIMON_MAX_LEN 30
 
-#define SIMON_GLYPH_OK 0x0065959696956500ULL
+#define SIMON_GLYPH_OK BB_ROWS( \
+    0b00000000, \
+    0b01100101, \
+    0b10010101, \
+    0b10010110, \
+    0b10010110, \
+    0b10010101, \
+    0b01100101, \
+    0b00000000)
+
+enum simon_phase {
+    SIMON_SHOW = 0,     // swiping in the sequence, SIMON_DELAY apart
+    SIMON_PROMPT,       // swiping in '?'
+    SIMON_QUERY,        // echoing presses until the sequence is done
+    SIMON_OK,           // swiping in SIMON_GLYPH_OK, then the next round
+    SIMON_FAIL,         // blinking, then game over
+};
 
 struct simon_data_t {
 	uint8_t points;
     uint8_t len;
     char seq[SIMON_MAX_LEN];
+    uint8_t phase;      // actual type: enum simon_phase
+    uint8_t pos;        // index into seq, or a step within the phase
+    int16_t wait_ms;    // left before the phase goes on
+    uint8_t n_keys;
+    char keys[4];       // presses queued during the query
+    // the swipe in progress; one pixel per tick
+    uint64_t from, to;
+    char dir;
+    uint8_t step;       // 8 when done
+    uint8_t tick_ms;    // settings.speed when the game started
 };
 
 unsigned play_simon();
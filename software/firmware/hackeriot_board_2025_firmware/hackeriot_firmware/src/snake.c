@@ -5,65 +5,44 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
-#include <zephyr/random/random.h>
 #include <zephyr/sys/printk.h>
 
-#include "buttons.h"
+#include "autopilot.h"
+#include "bitboard.h"
+#include "game.h"
 #include "screen.h"
 #include "snake.h"
 #include "persist.h"
-
-static bool snake_inside(struct snake_data_t *sd, uint8_t pos)
-{
-	for (unsigned i = 0; i < sd->len; i++)
-		if (pos == sd->pos[i]) return true;
-	return false;
-}
+#include "replay.h"
+#include "stats.h"
 
 static bool do_update(struct snake_data_t *sd)
 {
-	// debug prints
-	printk("points=%u target=%u len=%u grow=%u dir=%c pos=", 
-		sd->points, sd->target_pos, sd->len, sd->grow, "ULDR"[sd->direction]);
-	for (unsigned i = 0; i < sd->len; i++)
-		printk("%d ", sd->pos[i]);
-	printk("\n");
-
 	// update tail
 	if (sd->grow) {
 		++sd->len;
 		--sd->grow;
-	} else 
-		screen_pixel_off(sd->pos[sd->len - 1]);
-	
-	// update body
-	for (unsigned i = sd->len - 1; i > 0; i--) {
-		sd->pos[i] = sd->pos[i - 1];
+	} else {
+		uint8_t tail = SNAKE_POS(sd, sd->len - 1);
+		sd->occupied &= ~BB_BIT(tail);
 	}
 	
-	// update head
-	unsigned head = sd->pos[0];
+	// update head, wrapping around the edges
+	uint64_t head_bit = BB_BIT(SNAKE_POS(sd, 0));
 	switch(sd->direction) {
-		case 0:
-			head = (head + 8) & 63;
-			break;
-		case 1:
-			head += ((head & 7) == 7) ? -7 : 1;
-			break;
-		case 2:
-			head = (head + 56) & 63;
-			break;
-		case 3:
-			head += (head & 7) ? -1 : 7;
-			break;
+		case 0: head_bit = bb_wrap_up(head_bit);	break;
+		case 1: head_bit = bb_wrap_left(head_bit);	break;
+		case 2: head_bit = bb_wrap_down(head_bit);	break;
+		case 3: head_bit = bb_wrap_right(head_bit);	break;
 	}
-	if (snake_inside(sd, head)) {
+	unsigned head = bb_first(head_bit);
+	if (sd->occupied & head_bit) {
 		printk("Crash at pos=%d\n", head);
 		return false;
-	} else {
-		sd->pos[0] = head;
-		screen_pixel_on(head);
 	}
+	sd->head = (sd->head + 1) & (SNAKE_RING_SIZE - 1);
+	sd->pos[sd->head] = head;
+	sd->occupied |= head_bit;
 
 	// check if target reached
 	if (head == sd->target_pos) {
@@ -72,61 +51,143 @@ static bool do_update(struct snake_data_t *sd)
 		++sd->grow;
 		++sd->points;
 
-		// randomize new target outside snake
-		uint8_t tpos;
-		do
-			tpos = sys_rand8_get() & 63;
-		while(snake_inside(sd, tpos));
+		// new target: a random free cell; none left means a full board
+		uint64_t free = ~sd->occupied;
+		if ( ! free) {
+			printk("Board full\n");
+			return false;
+		}
+		uint8_t tpos = bb_select(free, replay_rand32() % bb_count(free));
 		sd->target_pos = tpos;
 		printk("New target at pos=%d\n", tpos);
-		screen_pixel_blink(tpos, true);
 	}
 	return true;
 }
 
-unsigned play_snake()
+static struct stats_hist_t snake_plan_us = STATS_HIST_INIT(3);
+
+static void snake_input(void *state, char btn)
 {
-	printk("[%s] new game\n", __func__);
+	struct snake_data_t *sd = state;
+	// any press takes over, as in a replayed game, but does not steer
+	if (sd->pilot == SNAKE_ATTRACT) {
+		printk("[%s] taken over\n", __func__);
+		sd->pilot = SNAKE_MANUAL;
+		sd->taken_over = true;
+		sd->n_turns = 0;
+		return;
+	}
+	// a quick U-turn takes two presses in one tick; keep both
+	if (sd->n_turns == ARRAY_SIZE(sd->turns))
+		return;
+	switch (btn) {
+		case 'U':	sd->turns[sd->n_turns++] = 0; break;
+		case 'L':	sd->turns[sd->n_turns++] = 1; break;
+		case 'D':	sd->turns[sd->n_turns++] = 2; break;
+		case 'R':	sd->turns[sd->n_turns++] = 3; break;
+	}
+}
+
+static bool snake_update(void *state)
+{
+	struct snake_data_t *sd = state;
+	if (sd->n_turns) {
+		sd->direction = sd->turns[0];
+		sd->turns[0] = sd->turns[1];
+		--sd->n_turns;
+	}
+	if (sd->pilot != SNAKE_MANUAL) {
+		uint32_t start = k_cycle_get_32();
+		sd->direction = autopilot_snake(sd);
+		stats_hist_add(&snake_plan_us, k_cyc_to_us_floor32(k_cycle_get_32() - start));
+	}
+	return do_update(sd);
+}
+
+static void snake_render(const void *state)
+{
+	const struct snake_data_t *sd = state;
+	screen_begin();
+	screen_set(sd->occupied);
+#if SCREEN_GRAY_BITS
+	// dim the body so the head stands out
+	screen_mask_gray(sd->occupied & ~BB_BIT(SNAKE_POS(sd, 0)), SCREEN_GRAY_MAX / 2);
+#endif
+	screen_pixel_blink(sd->target_pos, true);
+	screen_commit();
+}
+
+// increase speed every 5 points
+static uint32_t snake_tick_ms(const void *state)
+{
+	const struct snake_data_t *sd = state;
+	return 1400 / (sd->base + sd->points / 5);
+}
+
+static const struct game_t snake = {
+	.name		= "snake",
+	.buttons	= "UDLRABZX",	// all presses, for the attract mode
+	.input		= snake_input,
+	.update		= snake_update,
+	.render		= snake_render,
+	.tick_ms	= snake_tick_ms,
+};
+
+static unsigned snake_game(enum snake_pilot pilot, bool *taken_over)
+{
+	printk("[%s] new game, pilot=%d\n", __func__, pilot);
 
 	// init data
 	struct snake_data_t sd = {
 		.points		= 0,
-		.direction	= sys_rand8_get() & 3,
+		.direction	= replay_rand8() & 3,
 		.len 		= 1,
 		.grow		= INITIAL_SNAKE_LEN - 1,
 		.base     	= INITIAL_SNAKE_SPEED,
-		.target_pos = sys_rand8_get() & 63,
+		.target_pos = replay_rand8() & 63,
+		.pilot		= pilot,
 	};
 	// randomize distinct target and snake
-	sd.pos[0] = sd.target_pos ^ (sys_rand32_get() % 63);
-
-	// init screen
-	screen_set(0);
-	screen_pixel_on(sd.pos[0]);
-	screen_pixel_blink(sd.target_pos, true);
-
-	// game loop
-	while (do_update(&sd)) {
-		// increase speed every 5 points
-		unsigned speed = sd.base + (sd.points / 5);
-
-		char btn = buttons_get("UDLR", K_MSEC(1400 / speed));
-		switch (btn) {
-			case 'U':	sd.direction = 0; break;
-			case 'L':	sd.direction = 1; break;
-			case 'D':	sd.direction = 2; break;
-			case 'R':	sd.direction = 3; break;
-		}
-		//if (btn) printk("[%s] btn=%c\n", __func__, btn);
-	}
+	sd.pos[0] = sd.target_pos ^ (1 + replay_rand32() % 63);
+	sd.occupied = BB_BIT(sd.pos[0]);
+
+	bool headless = (pilot == SNAKE_HEADLESS);
+	game_run(&snake, &sd, headless ? GAME_HEADLESS : GAME_REALTIME);
+	if (taken_over)
+		*taken_over = sd.taken_over;
 	
 	// erase snake and target
-	for (unsigned i = 1; i <= sd.len; i++) {
-		screen_pixel_off(sd.pos[sd.len - i]);
-		k_msleep(100);
+	if ( ! headless) {
+		screen_set(sd.occupied);
+		for (unsigned i = 1; i <= sd.len; i++) {
+			screen_pixel_off(SNAKE_POS(&sd, sd.len - i));
+			k_msleep(100);
+		}
 	}
-	screen_pixel_off(sd.target_pos);
 
-	printk("[%s] game ended, score=%u\n", __func__, sd.points);
+	printk("[%s] game ended, score=%u len=%u\n", __func__, sd.points, sd.len);
 	return sd.points;
 }
+
+unsigned play_snake()
+{
+	return snake_game(SNAKE_MANUAL, NULL);
+}
+
+unsigned play_snake_auto(bool *taken_over)
+{
+	*taken_over = false;
+	return snake_game(SNAKE_ATTRACT, taken_over);
+}
+
+void snake_benchmark(unsigned games)
+{
+	stats_hist_reset(&snake_plan_us);
+	uint32_t start = k_uptime_get_32();
+	unsigned filled = 0;
+	for (unsigned i = 0; i < games; i++)
+		filled += (snake_game(SNAKE_HEADLESS, NULL) > 64 - INITIAL_SNAKE_LEN); // the last target fills it
+	printk("[%s] %u games, %u filled the board, %u ms\n", __func__, games, filled,
+		k_uptime_get_32() - start);
+	stats_hist_print("snake plan us", &snake_plan_us);
+}
@@ -8,21 +8,40 @@
 #ifndef __SNAKE_H__
 #define __SNAKE_H__
 
+#include <zephyr/kernel.h>
 
-#define MAX_SNAKE_LEN 60
+#define SNAKE_RING_SIZE 64	// power of 2, at least the 64 cells
 #define INITIAL_SNAKE_LEN 3
 #define INITIAL_SNAKE_SPEED 2
 
 struct snake_data_t {
-	unsigned points 	: 6; 
+	uint64_t occupied;			// bitboard of the body
+	unsigned points 	: 7; 
 	unsigned direction 	: 2; 	// 0=up, 1=left, 2=down, 3=right
-	unsigned len 		: 6;
+	unsigned len 		: 7;	// 1 to 64
 	unsigned grow 		: 2; 	// assuming INITIAL_SNAKE_LEN < 4
 	unsigned target_pos	: 6;
 	unsigned base		: 3; 	// base speed
-	uint8_t pos[MAX_SNAKE_LEN]; // head first
+	uint8_t head;				// index into pos
+	uint8_t pos[SNAKE_RING_SIZE]; // ring buffer, the tail len - 1 before head
+	uint8_t pilot;				// actual type: enum snake_pilot
+	bool taken_over;			// SNAKE_ATTRACT until a press
+	uint8_t n_turns;
+	uint8_t turns[2];			// directions pressed, one taken per tick
+};
+
+#define SNAKE_POS(sd, i)	((sd)->pos[((sd)->head - (i)) & (SNAKE_RING_SIZE - 1)])	// 0 is the head
+
+enum snake_pilot {
+	SNAKE_MANUAL = 0,
+	SNAKE_ATTRACT,		// autopilot, until a press takes over
+	SNAKE_HEADLESS,		// autopilot without input waits, for benchmarks
 };
 
 unsigned play_snake();
+unsigned play_snake_auto(bool *taken_over);
+
+// autopilot games at full speed; prints planner time per tick
+void snake_benchmark(unsigned games);
 
 #endif // __SNAKE_H__
@@ -0,0 +1,35 @@
+/*
+ * Copyright (c) 2025 Benny Meisels <benny.meisels@gmail.com>
+ *                    Rani Hod <rani.hod@gmail.com>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/sys/printk.h>
+
+#include "stats.h"
+
+void stats_hist_print(const char *name, const struct stats_hist_t *h)
+{
+	if ( ! h->count) {
+		printk("%s: none\n", name);
+		return;
+	}
+	printk("%s: n=%u avg=%u max=%u |", name, h->count, h->sum / h->count, h->max);
+	for (unsigned i = 0; i < STATS_BUCKETS; i++) {
+		if ( ! h->bucket[i])
+			continue;
+		if (i < STATS_BUCKETS - 1)
+			printk(" <%u:%u", 1U << (h->scale + i), h->bucket[i]);
+		else
+			printk(" >=%u:%u", 1U << (h->scale + i - 1), h->bucket[i]);
+	}
+	printk("\n");
+}
+
+void stats_hist_reset(struct stats_hist_t *h)
+{
+	uint8_t scale = h->scale;
+	memset(h, 0, sizeof(*h));
+	h->scale = scale;
+}
@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) 2025 Benny Meisels <benny.meisels@gmail.com>
+ *                    Rani Hod <rani.hod@gmail.com>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef __STATS_H__
+#define __STATS_H__
+
+#include <zephyr/kernel.h>
+
+#define STATS_BUCKETS   8
+
+// Log2 histogram: bucket 0 counts values below 2^scale, bucket i values
+// below 2^(scale+i), the last bucket everything else. Single writer, which
+// also does the resets, no locking; a reader may see a sample half-added,
+// which is fine here.
+struct stats_hist_t {
+	uint32_t	count;
+	uint32_t	sum;
+	uint32_t	max;
+	uint16_t	bucket[STATS_BUCKETS];
+	uint8_t		scale;
+};
+
+#define STATS_HIST_INIT(s)	{ .scale = (s) }
+
+static inline void stats_hist_add(struct stats_hist_t *h, uint32_t value)
+{
+	uint32_t v = value >> h->scale;
+	unsigned i = v ? 32 - __builtin_clz(v) : 0;
+	if (i >= STATS_BUCKETS) i = STATS_BUCKETS - 1;
+	if (h->bucket[i] < UINT16_MAX) ++h->bucket[i];
+	++h->count;
+	h->sum += value;
+	if (value > h->max) h->max = value;
+}
+
+void stats_hist_print(const char *name, const struct stats_hist_t *h);
+void stats_hist_reset(struct stats_hist_t *h);
+
+#endif // __STATS_H__
@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2025 Benny Meisels <benny.meisels@gmail.com>
+ *                    Rani Hod <rani.hod@gmail.com>
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Gestures end to end: input events in, buttons events out, with the
+// gesture work item timing repeats and long-presses.
+
+#include <zephyr/input/input.h>
+#include <zephyr/ztest.h>
+
+#include "buttons.h"
+#include "gesture.h"
+#include "replay.h"
+
+#define REPEATS 8
+
+// no replays here
+int replay_next(uint32_t mask, k_timeout_t timeout,
+	struct buttons_event_t *evt, k_timeout_t *wait) { return -1; }
+void replay_record(const struct buttons_event_t *evt) {}
+bool replay_full_speed() { return false; }
+void replay_take_over() {}
+
+static const struct gesture_key_t repeat_key = {
+	.repeat_delay_ms = 400,
+	.repeat_ms = 200,
+	.repeat_min_ms = 50,
+	.repeat_accel = 80,
+};
+
+static const struct gesture_key_t long_key = {
+	.long_ms = 1000,
+};
+
+static void *gesture_setup(void)
+{
+	gesture_set_key(BUTTON_DOWN, &repeat_key);
+	gesture_set_key(BUTTON_A, &long_key);
+	return NULL;
+}
+
+static void gesture_before(void *fixture)
+{
+	buttons_clear();
+}
+
+ZTEST(gesture, test_held_key_repeats_faster)
+{
+	struct buttons_event_t evt;
+	input_report_key(NULL, INPUT_BTN_DPAD_DOWN, 1, true, K_FOREVER);
+	zassert_true(buttons_get_event(BUTTONS_MASK_PRESS(BUTTON_DOWN), K_NO_WAIT, &evt));
+	uint32_t last = evt.cycles;
+
+	uint32_t interval[REPEATS];
+	for (unsigned i = 0; i < REPEATS; i++) {
+		zassert_true(buttons_get_event(BUTTONS_ALL, K_MSEC(1000), &evt),
+			"no repeat %u", i);
+		zassert_equal(evt.key, BUTTON_DOWN);
+		zassert_equal(evt.gesture, BUTTONS_REPEAT, "repeat %u came as %u", i, evt.gesture);
+		interval[i] = k_cyc_to_ms_near32(evt.cycles - last);
+		last = evt.cycles;
+	}
+	input_report_key(NULL, INPUT_BTN_DPAD_DOWN, 0, true, K_FOREVER);
+
+	// the delay, then intervals shrinking by repeat_accel down to the minimum
+	zassert_within(interval[0], repeat_key.repeat_delay_ms, 2);
+	zassert_within(interval[1], repeat_key.repeat_ms, 2);
+	for (unsigned i = 2; i < REPEATS; i++) {
+		zassert_true(interval[i] < interval[i - 1] ||
+			interval[i] <= repeat_key.repeat_min_ms + 1,
+			"interval %u: %u ms after %u ms", i, interval[i], interval[i - 1]);
+		zassert_true(interval[i] + 1 >= repeat_key.repeat_min_ms);
+	}
+
+	zassert_true(buttons_get_event(BUTTONS_ALL, K_NO_WAIT, &evt));
+	zassert_false(evt.pressed, "the release");
+	zassert_false(buttons_get_event(BUTTONS_ALL, K_MSEC(500), &evt), "repeats after release");
+}
+
+ZTEST(gesture, test_long_press_once)
+{
+	struct buttons_event_t evt;
+	input_report_key(NULL, INPUT_BTN_A, 1, true, K_FOREVER);
+	zassert_true(buttons_get_event(BUTTONS_ALL, K_NO_WAIT, &evt));
+	zassert_equal(evt.gesture, BUTTONS_RAW);
+
+	zassert_true(buttons_get_event(BUTTONS_ALL, K_MSEC(1500), &evt));
+	zassert_equal(evt.key, BUTTON_A);
+	zassert_equal(evt.gesture, BUTTONS_LONG);
+
+	// no second press, and nothing more while held
+	zassert_false(buttons_get_event(BUTTONS_ALL, K_MSEC(1500), &evt));
+	input_report_key(NULL, INPUT_BTN_A, 0, true, K_FOREVER);
+	zassert_true(buttons_get_event(BUTTONS_ALL, K_NO_WAIT, &evt));
+	zassert_false(evt.pressed);
+}
+
+ZTEST(gesture, test_filter_takes_repeats)
+{
+	struct buttons_event_t evt;
+	input_report_key(NULL, INPUT_BTN_DPAD_DOWN, 1, true, K_FOREVER);
+	k_msleep(repeat_key.repeat_delay_ms + 10);
+	input_report_key(NULL, INPUT_BTN_DPAD_DOWN, 0, true, K_FOREVER);
+
+	// the press, then a plain filter passes over the queued repeat
+	zassert_equal(buttons_get("D", K_NO_WAIT), 'D');
+	zassert_equal(buttons_get("D", K_NO_WAIT), 0, "a repeat read as a press");
+
+	// which stays queued for a filter that takes it
+	zassert_true(buttons_get_event(buttons_mask("U+D+"), K_NO_WAIT, &evt));
+	zassert_equal(evt.key, BUTTON_DOWN);
+	zassert_equal(evt.gesture, BUTTONS_REPEAT);
+	zassert_equal(buttons_get("d", K_NO_WAIT), 'd');
+}
+
+ZTEST_SUITE(gesture, NULL, gesture_setup, gesture_before, NULL, NULL);